@@ -15,9 +15,11 @@
  */
 
 #include "src/common.h"
+#include "src/arrow.h"
 #include "src/convert.h"
 #include "src/encoder.h"
 #include "src/row.h"
+#include "src/sink.h"
 #include "src/teradata.h"
 
 #include <signal.h>
@@ -116,6 +118,9 @@ static PyObject* Cmd_execute(Cmd *self, PyObject *args, PyObject *kwargs) {
         PyErr_SetString(TeradataError, "1: Connection not established.");
         return NULL;
     }
+    if (encoder_check_idle(self->encoder) != 0) {
+        return NULL;
+    }
     encoder_clear(self->encoder);
     if (self->cursor != NULL) {
         cursor_free(self->cursor);
@@ -159,8 +164,13 @@ static PyObject* Cmd_set_encoding(Cmd *self, PyObject *args) {
     if (settings & DECIMAL_RETURN_MASK) {
         new_settings = (self->encoder->Settings & ~DECIMAL_RETURN_MASK) | (settings & DECIMAL_RETURN_MASK);
     }
+    if (settings & CHAR_RETURN_MASK) {
+        new_settings = (self->encoder->Settings & ~CHAR_RETURN_MASK) | (settings & CHAR_RETURN_MASK);
+    }
     if (encoder_set_encoding(self->encoder, new_settings) != 0) {
-        PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        }
         return NULL;
     }
     Py_RETURN_ERROR(encoder_set_null(self->encoder, null));
@@ -289,7 +299,9 @@ static PyObject* Encoder_set_encoding(Encoder *self, PyObject *args) {
         return NULL;
     }
     if (encoder_set_encoding(self->encoder, settings) != 0) {
-        PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        }
         return NULL;
     }
     Py_RETURN_NONE;
@@ -306,7 +318,13 @@ static PyObject* Encoder_set_columns(Encoder *self, PyObject *args) {
         PyErr_SetString(PyExc_ValueError, "No columns found.");
         return NULL;
     }
-    self->encoder->Columns = columns;
+    if (encoder_check_idle(self->encoder) != 0) {
+        columns_free(columns);
+        return NULL;
+    }
+    if (encoder_set_columns(self->encoder, columns) != 0) {
+        return PyErr_NoMemory();
+    }
     Py_RETURN_NONE;
 }
 
@@ -319,6 +337,30 @@ static PyObject* Encoder_set_delimiter(Encoder *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject* Encoder_set_dedup(Encoder *self, PyObject *args) {
+    PyObject *obj;
+    if (!PyArg_ParseTuple(args, "O", &obj)) {
+        return NULL;
+    }
+    return encoder_set_dedup(self->encoder, obj);
+}
+
+static PyObject* Encoder_set_quoting(Encoder *self, PyObject *args) {
+    PyObject *obj;
+    if (!PyArg_ParseTuple(args, "O", &obj)) {
+        return NULL;
+    }
+    return encoder_set_quoting(self->encoder, obj);
+}
+
+static PyObject* Encoder_set_filter(Encoder *self, PyObject *args) {
+    PyObject *obj;
+    if (!PyArg_ParseTuple(args, "O", &obj)) {
+        return NULL;
+    }
+    return encoder_set_filter(self->encoder, obj);
+}
+
 static PyObject* Encoder_set_null(Encoder *self, PyObject *args) {
     PyObject *obj;
     if (!PyArg_ParseTuple(args, "O", &obj)) {
@@ -328,6 +370,46 @@ static PyObject* Encoder_set_null(Encoder *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject* Encoder_set_projection(Encoder *self, PyObject *args) {
+    PyObject *obj;
+    if (!PyArg_ParseTuple(args, "O", &obj)) {
+        return NULL;
+    }
+    return encoder_set_projection(self->encoder, obj);
+}
+
+static PyObject* Encoder_unpack_arrow(Encoder *self, PyObject *args) {
+    Py_buffer buffer;
+    PyObject *batch;
+    PyObject *capsules = NULL;
+    unsigned char *data;
+    if (!PyArg_ParseTuple(args, "s*", &buffer)) {
+        return NULL;
+    }
+    data = (unsigned char*)buffer.buf;
+    batch = teradata_buffer_to_arrow(self->encoder, &data, buffer.len);
+    PyBuffer_Release(&buffer);
+    if (batch != NULL) {
+        capsules = PyTuple_GET_ITEM(batch, 0);
+        Py_INCREF(capsules);
+        Py_DECREF(batch);
+    }
+    return capsules;
+}
+
+static PyObject* Encoder_unpack_columns(Encoder *self, PyObject *args) {
+    Py_buffer buffer;
+    PyObject *columns;
+    unsigned char *data;
+    if (!PyArg_ParseTuple(args, "s*", &buffer)) {
+        return NULL;
+    }
+    data = (unsigned char*)buffer.buf;
+    columns = teradata_buffer_to_columns(self->encoder, &data, buffer.len);
+    PyBuffer_Release(&buffer);
+    return columns;
+}
+
 static PyObject* Encoder_unpack_row(Encoder *self, PyObject *args) {
     Py_buffer buffer;
     PyObject *row;
@@ -361,16 +443,44 @@ static PyObject* Encoder_unpack_stmt_info(PyObject *self, PyObject *args) {
     return giraffez_columns_to_pyobject(columns);
 }
 
+static PyObject* Encoder_write_rows(Encoder *self, PyObject *args) {
+    Py_buffer buffer;
+    TextSink *sink;
+    int fd, n;
+    if (!PyArg_ParseTuple(args, "is*", &fd, &buffer)) {
+        return NULL;
+    }
+    if ((sink = text_sink_new(fd)) == NULL) {
+        PyBuffer_Release(&buffer);
+        return NULL;
+    }
+    n = text_sink_rows(sink, self->encoder, (unsigned char*)buffer.buf, buffer.len);
+    PyBuffer_Release(&buffer);
+    if (n < 0 || text_sink_flush(sink) != 0) {
+        text_sink_free(sink);
+        return NULL;
+    }
+    text_sink_free(sink);
+    return PyLong_FromLong(n);
+}
+
 static PyMethodDef Encoder_methods[] = {
     {"count_rows", (PyCFunction)Encoder_count_rows, METH_STATIC|METH_VARARGS, ""},
     {"pack_row", (PyCFunction)Encoder_pack_row, METH_VARARGS, ""},
     {"set_columns", (PyCFunction)Encoder_set_columns, METH_VARARGS, ""},
     {"set_delimiter", (PyCFunction)Encoder_set_delimiter, METH_VARARGS, ""},
     {"set_encoding", (PyCFunction)Encoder_set_encoding, METH_VARARGS, ""},
+    {"set_dedup", (PyCFunction)Encoder_set_dedup, METH_VARARGS, ""},
+    {"set_filter", (PyCFunction)Encoder_set_filter, METH_VARARGS, ""},
     {"set_null", (PyCFunction)Encoder_set_null, METH_VARARGS, ""},
+    {"set_projection", (PyCFunction)Encoder_set_projection, METH_VARARGS, ""},
+    {"set_quoting", (PyCFunction)Encoder_set_quoting, METH_VARARGS, ""},
+    {"unpack_arrow", (PyCFunction)Encoder_unpack_arrow, METH_VARARGS, ""},
+    {"unpack_columns", (PyCFunction)Encoder_unpack_columns, METH_VARARGS, ""},
     {"unpack_row", (PyCFunction)Encoder_unpack_row, METH_VARARGS, ""},
     {"unpack_rows", (PyCFunction)Encoder_unpack_rows, METH_VARARGS, ""},
     {"unpack_stmt_info", (PyCFunction)Encoder_unpack_stmt_info, METH_STATIC|METH_VARARGS, ""},
+    {"write_rows", (PyCFunction)Encoder_write_rows, METH_VARARGS, ""},
     {NULL}  /* Sentinel */
 };
 
@@ -488,6 +598,10 @@ MOD_INIT(_teradata)
 {
     PyObject* m;
 
+    if (PyType_Ready(&ArrayType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
     if (PyType_Ready(&CmdType) < 0) {
         return MOD_ERROR_VAL;
     }
@@ -496,6 +610,14 @@ MOD_INIT(_teradata)
         return MOD_ERROR_VAL;
     }
 
+    if (PyType_Ready(&LazyRowType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
+    if (PyType_Ready(&RowSchemaType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
 #if PY_MAJOR_VERSION >= 3
     m = PyModule_Create(&moduledef);
 #else
@@ -519,10 +641,15 @@ MOD_INIT(_teradata)
         return MOD_ERROR_VAL;
     }
 
+    Py_INCREF(&ArrayType);
+    PyModule_AddObject(m, "Array", (PyObject*)&ArrayType);
     Py_INCREF(&CmdType);
     PyModule_AddObject(m, "Cmd", (PyObject*)&CmdType);
     Py_INCREF(&EncoderType);
     PyModule_AddObject(m, "Encoder", (PyObject*)&EncoderType);
+
+    Py_INCREF(&LazyRowType);
+    PyModule_AddObject(m, "LazyRow", (PyObject*)&LazyRowType);
     return MOD_SUCCESS_VAL(m);
 }
 
@@ -118,6 +118,10 @@ static PyObject* Export_columns(Export *self) {
     return self->conn->Columns();
 }
 
+static PyObject* Export_get_block(Export *self) {
+    return self->conn->GetBlock();
+}
+
 static PyObject* Export_get_buffer(Export *self) {
     return self->conn->GetBuffer();
 }
@@ -147,13 +151,34 @@ static PyObject* Export_set_encoding(Export *self, PyObject *args) {
     if (settings & DECIMAL_RETURN_MASK) {
         new_settings = (new_settings & ~DECIMAL_RETURN_MASK) | settings;
     }
+    if (settings & CHAR_RETURN_MASK) {
+        new_settings = (new_settings & ~CHAR_RETURN_MASK) | settings;
+    }
     if (encoder_set_encoding(self->conn->encoder, new_settings) != 0) {
-        PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        }
         return NULL;
     }
     Py_RETURN_NONE;
 }
 
+static PyObject* Export_set_dedup(Export *self, PyObject *args) {
+    PyObject *dedup = NULL;
+    if (!PyArg_ParseTuple(args, "O", &dedup)) {
+        return NULL;
+    }
+    return encoder_set_dedup(self->conn->encoder, dedup);
+}
+
+static PyObject* Export_set_filter(Export *self, PyObject *args) {
+    PyObject *predicates = NULL;
+    if (!PyArg_ParseTuple(args, "O", &predicates)) {
+        return NULL;
+    }
+    return encoder_set_filter(self->conn->encoder, predicates);
+}
+
 static PyObject* Export_set_null(Export *self, PyObject *args) {
     PyObject *null = NULL;
     if (!PyArg_ParseTuple(args, "O", &null)) {
@@ -163,6 +188,38 @@ static PyObject* Export_set_null(Export *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject* Export_set_quoting(Export *self, PyObject *args) {
+    PyObject *quoting = NULL;
+    if (!PyArg_ParseTuple(args, "O", &quoting)) {
+        return NULL;
+    }
+    return encoder_set_quoting(self->conn->encoder, quoting);
+}
+
+static PyObject* Export_set_projection(Export *self, PyObject *args) {
+    PyObject *projection = NULL;
+    if (!PyArg_ParseTuple(args, "O", &projection)) {
+        return NULL;
+    }
+    return encoder_set_projection(self->conn->encoder, projection);
+}
+
+static PyObject* Export_write_to(Export *self, PyObject *args) {
+    int fd;
+    if (!PyArg_ParseTuple(args, "i", &fd)) {
+        return NULL;
+    }
+    return self->conn->WriteTo(fd);
+}
+
+static PyObject* Export_set_workers(Export *self, PyObject *args) {
+    int workers = 0;
+    if (!PyArg_ParseTuple(args, "i", &workers)) {
+        return NULL;
+    }
+    return self->conn->SetWorkers(workers);
+}
+
 static PyObject* Export_set_delimiter(Export *self, PyObject *args) {
     PyObject *delimiter = NULL;
     if (!PyArg_ParseTuple(args, "O", &delimiter)) {
@@ -193,13 +250,20 @@ static PyMethodDef Export_methods[] = {
     {"add_attribute", (PyCFunction)Export_add_attribute, METH_VARARGS, ""},
     {"close", (PyCFunction)Export_close, METH_NOARGS, ""},
     {"columns", (PyCFunction)Export_columns, METH_NOARGS, ""},
+    {"get_block", (PyCFunction)Export_get_block, METH_NOARGS, ""},
     {"get_buffer", (PyCFunction)Export_get_buffer, METH_NOARGS, ""},
     {"get_event", (PyCFunction)Export_get_event, METH_VARARGS, ""},
     {"initiate", (PyCFunction)Export_initiate, METH_NOARGS, ""},
+    {"set_dedup", (PyCFunction)Export_set_dedup, METH_VARARGS, ""},
     {"set_encoding", (PyCFunction)Export_set_encoding, METH_VARARGS, ""},
+    {"set_filter", (PyCFunction)Export_set_filter, METH_VARARGS, ""},
     {"set_null", (PyCFunction)Export_set_null, METH_VARARGS, ""},
     {"set_delimiter", (PyCFunction)Export_set_delimiter, METH_VARARGS, ""},
+    {"set_projection", (PyCFunction)Export_set_projection, METH_VARARGS, ""},
     {"set_query", (PyCFunction)Export_set_query, METH_VARARGS, ""},
+    {"set_quoting", (PyCFunction)Export_set_quoting, METH_VARARGS, ""},
+    {"set_workers", (PyCFunction)Export_set_workers, METH_VARARGS, ""},
+    {"write_to", (PyCFunction)Export_write_to, METH_VARARGS, ""},
     {NULL}  /* Sentinel */
 };
 
@@ -352,7 +416,9 @@ static PyObject* MLoad_set_encoding(MLoad *self, PyObject *args, PyObject *kwarg
         new_settings = (self->conn->encoder->Settings & ~DECIMAL_RETURN_MASK) | settings;
     }
     if (encoder_set_encoding(self->conn->encoder, new_settings) != 0) {
-        PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_ValueError, "Encoder set_encoding failed, bad encoding '0x%06x'.", settings);
+        }
         return NULL;
     }
     Py_RETURN_NONE;
@@ -531,6 +597,18 @@ MOD_INIT(_teradatapt)
         return MOD_ERROR_VAL;
     }
 
+    if (PyType_Ready(&LazyRowType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
+    if (PyType_Ready(&RowSchemaType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
+    if (PyType_Ready(&RawBlockType) < 0) {
+        return MOD_ERROR_VAL;
+    }
+
     MOD_DEF(m, "_teradatapt", "", module_methods);
 
     giraffez_types_import();
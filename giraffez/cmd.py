@@ -202,6 +202,23 @@ class Cursor(object):
         self.processor = lambda x, y: Row(x, y)
         return self
 
+    def to_namedtuple(self):
+        """
+        Set the current encoder output to named tuples and returns the
+        cursor. Fields are read by attribute or index as with
+        :class:`giraffez.Row`, but the row type is built in C for each
+        statement and rows take about half the memory of dict rows.
+
+        .. code-block:: python
+
+            with giraffez.Cmd() as cmd:
+                for row in cmd.execute(query).to_namedtuple():
+                    print(row.infokey, row[1])
+        """
+        self.conn.set_encoding(ROW_ENCODING_NAMEDTUPLE)
+        self.processor = lambda x, y: y
+        return self
+
     def next(self):
         return self.__next__()
 
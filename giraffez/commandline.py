@@ -198,6 +198,7 @@ class ExportCommand(Command):
         Argument("-j", "--json", default=False, help="Export in json format"),
         Argument("-d", "--delimiter", default="|", help="Text delimiter"),
         Argument("-n", "--null", default="NULL", help="Set null character"),
+        Argument("-q", "--quote", default=False, help="Quote values containing the delimiter, quotes or newlines"),
         Argument("--no-header", default=False, help="Do not prepend header"),
     ]
 
@@ -232,7 +233,7 @@ class ExportCommand(Command):
                         exportfn = export.to_json
                         export.options("encoding", "json", 5)
                     else:
-                        exportfn = lambda: export.to_str(args.delimiter, args.null)
+                        exportfn = lambda: export.to_str(args.delimiter, args.null, args.quote)
                         export.options("encoding", "str", 5)
                     export._initiate()
                     if out.is_stdout:
@@ -240,10 +241,22 @@ class ExportCommand(Command):
                     if not args.no_header:
                         out.writen(args.delimiter.join(export.columns.names))
                     i = 0
-                    for i, row in enumerate(exportfn(), 1):
-                        if i % 100000 == 0 and args.output_file:
-                            log.info("\rExport", "Processed {} rows".format(i), console=True)
-                        out.writen(row)
+                    if args.gzip:
+                        for i, row in enumerate(exportfn(), 1):
+                            if i % 100000 == 0 and args.output_file:
+                                log.info("\rExport", "Processed {} rows".format(i), console=True)
+                            out.writen(row)
+                    else:
+                        # Rows are written by the encoder straight to the
+                        # file descriptor of the output
+                        if args.json:
+                            writer = export.write_json_to(out.fd)
+                        else:
+                            writer = export.write_to(out.fd, args.delimiter, args.null, args.quote)
+                        for n in writer:
+                            i += n
+                            if args.output_file:
+                                log.info("\rExport", "Processed {} rows".format(i), console=True)
                     if args.output_file:
                         log.info("\rExport", "Processed {} rows".format(i))
                     if out.is_stdout:
@@ -965,6 +965,10 @@ ROW_ENCODING_STRING   = 0x01
 ROW_ENCODING_DICT     = 0x02
 ROW_ENCODING_LIST     = 0x04
 ROW_ENCODING_RAW      = 0x08
+ROW_ENCODING_ARROW    = 0x10
+ROW_ENCODING_LAZY     = 0x20
+ROW_ENCODING_NAMEDTUPLE = 0x40
+ROW_ENCODING_JSON     = 0x80
 ROW_RETURN_MASK       = 0xff
 
 DATETIME_AS_INVALID        = 0x0000
@@ -976,8 +980,13 @@ DECIMAL_AS_INVALID          = 0x000000
 DECIMAL_AS_STRING           = 0x010000
 DECIMAL_AS_FLOAT            = 0x020000
 DECIMAL_AS_GIRAFFEZ_DECIMAL = 0x040000
+DECIMAL_AS_SCALED_INT       = 0x080000
 DECIMAL_RETURN_MASK         = 0xff0000
 
+CHAR_AS_PADDED              = 0x01000000
+CHAR_AS_TRIMMED             = 0x02000000
+CHAR_RETURN_MASK            = 0xff000000
+
 ENCODER_SETTINGS_DEFAULT = ROW_ENCODING_LIST | DATETIME_AS_STRING | DECIMAL_AS_FLOAT
 ENCODER_SETTINGS_STRING  = ROW_ENCODING_STRING | DATETIME_AS_STRING | DECIMAL_AS_STRING
 ENCODER_SETTINGS_JSON    = ROW_ENCODING_DICT | DATETIME_AS_STRING | DECIMAL_AS_FLOAT
@@ -989,9 +998,16 @@ encoder_settings_map = {
     0x04: 'ROW_ENCODING_LIST',
     0x08: 'ROW_ENCODING_RAW',
     0x08: 'ROW_ENCODING_RAW',
+    0x10: 'ROW_ENCODING_ARROW',
+    0x20: 'ROW_ENCODING_LAZY',
+    0x40: 'ROW_ENCODING_NAMEDTUPLE',
+    0x80: 'ROW_ENCODING_JSON',
     0x0100: 'DATETIME_AS_STRING',
     0x0200: 'DATETIME_AS_GIRAFFE_TYPES',
     0x010000: 'DECIMAL_AS_STRING',
     0x020000: 'DECIMAL_AS_FLOAT',
     0x040000: 'DECIMAL_AS_GIRAFFEZ_DECIMAL',
+    0x080000: 'DECIMAL_AS_SCALED_INT',
+    0x01000000: 'CHAR_AS_PADDED',
+    0x02000000: 'CHAR_AS_TRIMMED',
 }
@@ -35,6 +35,42 @@ from ._compat import *
 
 
 
+class ArrowBatch(object):
+    """
+    A block of rows decoded into the Arrow C Data Interface. The batch
+    implements the Arrow PyCapsule protocol so it can be passed directly to
+    :code:`pyarrow.record_batch`, :code:`polars.from_arrow` or
+    :code:`duckdb` without giraffez depending on any of them.
+
+    The underlying memory is moved into the consumer on import, so a batch
+    can only be imported once.
+
+    :param tuple capsules: The :code:`(arrow_schema, arrow_array)` capsule pair
+        returned by the C encoder.
+    """
+    def __init__(self, capsules):
+        self.schema_capsule, self.array_capsule = capsules
+
+    def __arrow_c_array__(self, requested_schema=None):
+        return self.schema_capsule, self.array_capsule
+
+    def to_pyarrow(self):
+        """
+        Import the batch as a :code:`pyarrow.RecordBatch`.
+
+        :rtype: :code:`pyarrow.RecordBatch`
+        """
+        import pyarrow
+        if hasattr(pyarrow.RecordBatch, "_import_from_c_capsule"):
+            return pyarrow.RecordBatch._import_from_c_capsule(self.schema_capsule, self.array_capsule)
+        import ctypes
+        get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+        get_pointer.restype = ctypes.c_void_p
+        get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+        return pyarrow.RecordBatch._import_from_c(get_pointer(self.array_capsule, b"arrow_array"),
+            get_pointer(self.schema_capsule, b"arrow_schema"))
+
+
 class TeradataEncoder(object):
     """
     The class wrapping the Teradata C encoder.
@@ -49,6 +85,10 @@ class TeradataEncoder(object):
         self._columns = columns
         self._delimiter = '|'
         self._null = None
+        self._projection = None
+        self._filter = None
+        self._dedup = None
+        self._quoting = False
         self.encoder = Encoder(columns)
         if encoding is not None:
             self |= encoding
@@ -68,6 +108,21 @@ class TeradataEncoder(object):
     def count(self, data):
         return Encoder.count_rows(data)
 
+    @property
+    def dedup(self):
+        return self._dedup
+
+    @dedup.setter
+    def dedup(self, names):
+        """
+        Share the objects decoded from repeated values of the named CHAR,
+        VARCHAR and DATE columns, or of every such column when set to
+        :code:`True`, rather than creating an object for each value. Set
+        to :code:`None` to create a new object for every value.
+        """
+        self.encoder.set_dedup(names)
+        self._dedup = names
+
     @property
     def delimiter(self):
         return self._delimiter
@@ -75,7 +130,25 @@ class TeradataEncoder(object):
     @delimiter.setter
     def delimiter(self, value):
         self._delimiter = value
-        self.encoder.set_delimiter(self._delimtier)
+        self.encoder.set_delimiter(self._delimiter)
+
+    @property
+    def filter(self):
+        return self._filter
+
+    @filter.setter
+    def filter(self, predicates):
+        """
+        Only return the rows of :meth:`readbuffer` matching every predicate.
+        Predicates are tuples of :code:`(column, op, value)` where op is one
+        of :code:`=`, :code:`!=`, :code:`<`, :code:`<=`, :code:`>`,
+        :code:`>=` or :code:`in` (with an iterable of values), or
+        :code:`(column, 'is null')` and :code:`(column, 'is not null')`.
+        They are evaluated on the raw row before it is decoded. Set to
+        :code:`None` to return every row.
+        """
+        self.encoder.set_filter(predicates)
+        self._filter = predicates
 
     @property
     def null(self):
@@ -86,15 +159,63 @@ class TeradataEncoder(object):
         self._null = value
         self.encoder.set_null(self._null)
 
+    @property
+    def projection(self):
+        return self._projection
+
+    @projection.setter
+    def projection(self, names):
+        """
+        Decode only the named columns, in the order they appear in
+        :attr:`columns`. The other columns are skipped without being
+        converted. Set to :code:`None` to decode every column.
+        """
+        self.encoder.set_projection(names)
+        self._projection = list(names) if names else None
+
+    @property
+    def quoting(self):
+        return self._quoting
+
+    @quoting.setter
+    def quoting(self, value):
+        """
+        Enclose text values that contain the delimiter, a double quote or a
+        line break in double quotes, doubling any double quotes within
+        them (RFC 4180). Other values are written unchanged.
+        """
+        self.encoder.set_quoting(value)
+        self._quoting = bool(value)
+
     def parse_header(self, data):
         return self.encoder.unpack_stmt_info(data)
 
     def read(self, data):
         return self.encoder.unpack_row(data)
 
+    def readarrow(self, data):
+        """
+        Decode a block of rows into an :class:`ArrowBatch`.
+
+        :rtype: :class:`ArrowBatch`
+        """
+        return ArrowBatch(self.encoder.unpack_arrow(data))
+
     def readbuffer(self, data):
         return self.encoder.unpack_rows(data)
 
+    def readcolumns(self, data):
+        """
+        Decode a block of rows into one :code:`(validity, offsets, values)`
+        tuple per column. Each item is a :code:`giraffez.Array` supporting
+        the buffer protocol. :code:`validity` is a bitmap (LSB first) with
+        a bit set for each non-null value, :code:`values` is an int64 or
+        double array for numeric columns, and for all other columns
+        :code:`values` holds the raw bytes delimited by the int32
+        :code:`offsets` (:code:`None` for numeric columns).
+        """
+        return self.encoder.unpack_columns(data)
+
     def serialize(self, data):
         return self.encoder.pack_row(data)
 
@@ -102,6 +223,16 @@ class TeradataEncoder(object):
         self.encoding = ENCODER_SETTINGS_DEFAULT
         self.encoder.set_encoding(self.encoding)
 
+    def writebuffer(self, fd, data):
+        """
+        Write a block of rows to the file descriptor :code:`fd` as text,
+        one row per line, formatted the same as with
+        :code:`ROW_ENCODING_STRING` without creating a string per row.
+
+        :rtype: ``int`` (the number of rows written)
+        """
+        return self.encoder.write_rows(fd, data)
+
     def __or__(self, other):
         if other & ROW_RETURN_MASK:
             self.encoding = self.encoding & ~ROW_RETURN_MASK | other
@@ -109,6 +240,8 @@ class TeradataEncoder(object):
             self.encoding = self.encoding & ~DATETIME_RETURN_MASK | other
         if other & DECIMAL_RETURN_MASK:
             self.encoding = self.encoding & ~DECIMAL_RETURN_MASK | other
+        if other & CHAR_RETURN_MASK:
+            self.encoding = self.encoding & ~CHAR_RETURN_MASK | other
         self.encoder.set_encoding(self.encoding)
         self.encoder.set_delimiter(self._delimiter)
         self.encoder.set_null(self._null)
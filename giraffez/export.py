@@ -25,7 +25,7 @@ from .errors import *
 from ._teradatapt import InvalidCredentialsError
 from .config import Config
 from .connection import Connection, Context
-from .encoders import dict_to_json, TeradataEncoder
+from .encoders import ArrowBatch, TeradataEncoder
 from .fmt import truncate
 from .logging import log
 from .sql import parse_statement, remove_curly_quotes
@@ -61,6 +61,13 @@ class TeradataBulkExport(Connection):
         command :code:`giraffez config --unlock <connection>` changing the connection password,
         or via the :meth:`~giraffez.config.Config.unlock_connection` method.
     :param bool coerce_floats: Coerce Teradata decimal types into Python floats
+    :param bool scaled_ints: Return Teradata decimal types as Python ints holding
+        the unscaled value, so that 12.34 in a :code:`DECIMAL(10,2)` column is
+        returned as :code:`1234`. The scale is that of the column in :attr:`columns`.
+        Takes precedence over :code:`coerce_floats`
+    :param bool trim_chars: Remove the trailing padding of Teradata CHAR values
+    :param int decode_workers: Decode up to this many buffers at the same time on
+        separate threads when rows are returned as lists, dicts or named tuples
     :raises `giraffez.errors.InvalidCredentialsError`: if the supplied credentials are incorrect
     :raises `giraffez.TeradataError`: if the connection cannot be established
 
@@ -78,12 +85,18 @@ class TeradataBulkExport(Connection):
 
     def __init__(self, query=None, host=None, username=None, password=None,
             log_level=INFO, config=None, key_file=None, dsn=None, protect=False,
-            coerce_floats=True):
+            coerce_floats=True, scaled_ints=False, trim_chars=False, decode_workers=1):
         super(TeradataBulkExport, self).__init__(host, username, password, log_level, config, key_file,
             dsn, protect)
         # Attributes used with property getter/setters
         self._query = None
+        self._projection = None
+        self._filter = None
+        self._dedup = None
         self.coerce_floats = coerce_floats
+        self.scaled_ints = scaled_ints
+        self.trim_chars = trim_chars
+        self.decode_workers = decode_workers
         self.initiated = False
         #: The amount of time spent in idle (waiting for server)
         self.idle_time = 0
@@ -98,6 +111,94 @@ class TeradataBulkExport(Connection):
         """
         return self.export.columns()
     
+    @property
+    def dedup(self):
+        """
+        :return: The columns whose repeated values share a single object,
+            :code:`True` for every eligible column, or :code:`None`
+        """
+        return self._dedup
+
+    @dedup.setter
+    def dedup(self, names):
+        """
+        Share the objects decoded from repeated values of the named CHAR,
+        VARCHAR and DATE columns rather than creating an object for each
+        value. Status codes, country codes and dates often repeat millions
+        of times, so materialized results use much less memory. Values are
+        cached by their raw bytes, up to 1024 distinct values per column.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                export.dedup = ["country_code", "order_date"]
+                rows = list(export.to_list())
+
+        :param names: Names of the columns to share values of, or
+            :code:`True` for every CHAR, VARCHAR and DATE column
+        """
+        self.export.set_dedup(names)
+        self._dedup = names
+
+    @property
+    def filter(self):
+        """
+        :return: The predicates rows must match to be returned, or
+            :code:`None` if every row is returned
+        :rtype: list
+        """
+        return self._filter
+
+    @filter.setter
+    def filter(self, predicates):
+        """
+        Only return the rows of :meth:`to_dict`, :meth:`to_lazy`,
+        :meth:`to_list`, :meth:`to_namedtuple`, :meth:`to_json` and
+        :meth:`to_str` that match
+        every predicate, for filtering the server cannot do such as
+        matching a local set of keys. Rows are tested before they are
+        decoded so the rows filtered out cost very little.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                export.filter = [("account_id", "in", keys), ("closed", "is null")]
+                for row in export.to_dict():
+                    print(row)
+
+        :param list predicates: Tuples of :code:`(column, op, value)` where
+            op is one of :code:`=`, :code:`!=`, :code:`<`, :code:`<=`,
+            :code:`>`, :code:`>=` or :code:`in` (with an iterable of values),
+            or :code:`(column, 'is null')` and :code:`(column, 'is not null')`
+        """
+        self.export.set_filter(predicates)
+        self._filter = predicates
+
+    @property
+    def projection(self):
+        """
+        :return: The names of the columns included in decoded rows, or
+            :code:`None` if every column is included
+        :rtype: list
+        """
+        return self._projection
+
+    @projection.setter
+    def projection(self, names):
+        """
+        Restrict the rows returned by :meth:`to_dict`, :meth:`to_list`,
+        :meth:`to_json` and :meth:`to_str` to the named columns. The
+        remaining columns are skipped while decoding without being
+        converted, which is useful when exporting from a view that selects
+        more columns than are needed. Columns are returned in the order
+        they appear in the query. Set to :code:`None` to include every
+        column.
+
+        :param list names: Names of the columns to include
+        """
+        self.export.set_projection(names)
+        self._projection = list(names) if names else None
+
     @property
     def query(self):
         """
@@ -169,10 +270,65 @@ class TeradataBulkExport(Connection):
             raise GiraffeError("Archive writer must be in binary mode")
         writer.write(GIRAFFE_MAGIC)
         writer.write(self.columns.serialize())
-        i = 0
-        for n, chunk in enumerate(self._fetchall(ROW_ENCODING_RAW), 1):
-            writer.write(chunk)
-            yield TeradataEncoder.count(chunk)
+        self._set_encoding(ROW_ENCODING_RAW)
+        while True:
+            block = self.export.get_block()
+            if block is None:
+                return
+            writer.write(block)
+            n = TeradataEncoder.count(block)
+            # Released before the next block is received, so its buffer
+            # is reused
+            del block
+            yield n
+
+    def to_arrow(self):
+        """
+        Sets the current encoder output to Arrow and returns an iterator
+        of record batches, one for each block received from Teradata.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                table = pyarrow.Table.from_batches(b.to_pyarrow() for b in export.to_arrow())
+
+        :rtype: iterator (yields :class:`~giraffez.encoders.ArrowBatch`)
+        """
+        return self._fetchall(ROW_ENCODING_ARROW, processor=ArrowBatch)
+
+    def to_blocks(self):
+        """
+        Returns an iterator of the blocks of rows exactly as they are
+        received from the server, in the same format as
+        :code:`ROW_ENCODING_RAW`. Blocks support the buffer protocol, so
+        they can be written to a file or wrapped in a :code:`memoryview`
+        directly.
+
+        A block first refers to the buffer of the export operator, which is
+        reused for the next block and freed when the export is closed. Its
+        data is copied once, to a buffer of its own, when a view of it is
+        first taken, such as by writing it to a file, or when it is still
+        referenced as the next block is received. Blocks and views kept
+        after the export is closed remain valid. Deleting each block before
+        the next lets its buffer be reused.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                with open("database.table_name.bin", "wb") as f:
+                    for block in export.to_blocks():
+                        f.write(block)
+                        del block
+
+        :rtype: iterator (yields ``RawBlock``)
+        """
+        self._set_encoding(ROW_ENCODING_RAW)
+        while True:
+            block = self.export.get_block()
+            if block is None:
+                return
+            yield block
+            del block
 
     def to_dict(self):
         """
@@ -186,11 +342,31 @@ class TeradataBulkExport(Connection):
     def to_json(self):
         """
         Sets the current encoder output to json encoded strings and
-        returns a row iterator.
+        returns a row iterator. Rows are encoded as JSON objects directly
+        from the data received, without creating a :code:`dict` for each
+        row, in the same format as :code:`json.dumps`.
 
         :rtype: iterator (yields ``str``)
         """
-        return self._fetchall(ROW_ENCODING_DICT, processor=dict_to_json)
+        return self._fetchall(ROW_ENCODING_JSON)
+
+    def to_lazy(self):
+        """
+        Sets the current encoder output to lazy rows and returns a row
+        iterator. Each row keeps a reference to the block it was received
+        in and only converts a column when it is accessed, by index or by
+        column name, which is much cheaper when only a few columns of a
+        wide row are read.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                for row in export.to_lazy():
+                    print(row["col1"], row[-1])
+
+        :rtype: iterator (yields ``giraffez._teradata.LazyRow``)
+        """
+        return self._fetchall(ROW_ENCODING_LAZY)
 
     def to_list(self):
         """
@@ -201,7 +377,23 @@ class TeradataBulkExport(Connection):
         """
         return self._fetchall(ROW_ENCODING_LIST)
 
-    def to_str(self, delimiter='|', null='NULL'):
+    def to_namedtuple(self):
+        """
+        Sets the current encoder output to named tuples and returns a row
+        iterator. The row type is built once from the column titles, so
+        fields can be read by attribute as well as by index:
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                for row in export.to_namedtuple():
+                    print(row.col1, row[1])
+
+        :rtype: iterator (yields ``giraffez.Row`` struct sequences)
+        """
+        return self._fetchall(ROW_ENCODING_NAMEDTUPLE)
+
+    def to_str(self, delimiter='|', null='NULL', quoting=False):
         """
         Sets the current encoder output to Python `str` and returns
         a row iterator.
@@ -209,15 +401,72 @@ class TeradataBulkExport(Connection):
         :param str null: The string representation of null values
         :param str delimiter: The string delimiting values in the output
             string
+        :param bool quoting: Enclose values containing the delimiter, a
+            double quote or a line break in double quotes (RFC 4180)
 
         :rtype: iterator (yields ``str``)
         """
         self.export.set_null(null)
         self.export.set_delimiter(delimiter)
+        self.export.set_quoting(quoting)
         self.options("delimiter", escape_string(delimiter), 2)
         self.options("null", null, 3)
         return self._fetchall(ENCODER_SETTINGS_STRING, coerce_floats=False)
 
+    def write_to(self, fd, delimiter='|', null='NULL', quoting=False):
+        """
+        Writes the rows directly to a file as delimited text, one row per
+        line, the same as those returned by :meth:`to_str`. Rows are
+        formatted into a large buffer that is written out as it fills,
+        without creating a Python string for each row.
+
+        .. code-block:: python
+
+            with giraffez.BulkExport("database.table_name") as export:
+                with open("database.table_name.txt", "w") as f:
+                    for n in export.write_to(f):
+                        print("Rows: {}".format(n))
+
+        :param fd: A file descriptor, or a file object which is flushed
+            before any rows are written to its descriptor
+        :param str null: The string representation of null values
+        :param str delimiter: The string delimiting values in the output
+        :param bool quoting: Enclose values containing the delimiter, a
+            double quote or a line break in double quotes (RFC 4180)
+
+        :rtype: iterator (yields ``int``)
+        """
+        self.export.set_null(null)
+        self.export.set_delimiter(delimiter)
+        self.export.set_quoting(quoting)
+        self.options("delimiter", escape_string(delimiter), 2)
+        self.options("null", null, 3)
+        self._set_encoding(ENCODER_SETTINGS_STRING, coerce_floats=False)
+        return self._write_to(fd)
+
+    def write_json_to(self, fd):
+        """
+        Writes the rows directly to a file as JSON objects, one row per
+        line, the same as those returned by :meth:`to_json`.
+
+        :param fd: A file descriptor, or a file object which is flushed
+            before any rows are written to its descriptor
+
+        :rtype: iterator (yields ``int``)
+        """
+        self._set_encoding(ROW_ENCODING_JSON)
+        return self._write_to(fd)
+
+    def _write_to(self, fd):
+        if hasattr(fd, "fileno"):
+            fd.flush()
+            fd = fd.fileno()
+        while True:
+            n = self.export.write_to(fd)
+            if n is None:
+                return
+            yield n
+
     def _close(self, exc=None):
         log.info("Export", "Closing Teradata PT connection ...")
         self.export.close()
@@ -239,29 +488,41 @@ class TeradataBulkExport(Connection):
         log.info(self.options)
 
     def _fetchall(self, encoding, coerce_floats=None, processor=None):
-        if self.query is None:
-            raise GiraffeError("Must set target table or query.")
-        if not self.initiated:
-            self._initiate()
-        self.export.set_encoding(encoding)
+        self._set_encoding(encoding, coerce_floats)
         if processor is None:
             processor =  identity
-        if coerce_floats is None:
-            coerce_floats = self.coerce_floats
-        if coerce_floats:
-            self.export.set_encoding(DECIMAL_AS_FLOAT)
-        else:
-            self.export.set_encoding(DECIMAL_AS_STRING)
         while True:
             try:
                 data = self.export.get_buffer()
-                if not data:
+                # A buffer whose rows were all excluded by the filter is
+                # empty, only None marks the end of the export
+                if data is None:
                     return
                 for row in data:
                     yield processor(row)
             except StopIteration:
                 return
 
+    def _set_encoding(self, encoding, coerce_floats=None):
+        if self.query is None:
+            raise GiraffeError("Must set target table or query.")
+        if not self.initiated:
+            self._initiate()
+        self.export.set_encoding(encoding)
+        if coerce_floats is None:
+            coerce_floats = self.coerce_floats
+        if self.scaled_ints:
+            self.export.set_encoding(DECIMAL_AS_SCALED_INT)
+        elif coerce_floats:
+            self.export.set_encoding(DECIMAL_AS_FLOAT)
+        else:
+            self.export.set_encoding(DECIMAL_AS_STRING)
+        if self.trim_chars:
+            self.export.set_encoding(CHAR_AS_TRIMMED)
+        else:
+            self.export.set_encoding(CHAR_AS_PADDED)
+        self.export.set_workers(self.decode_workers)
+
 
 class BulkExport(Context):
     __instance__ = TeradataBulkExport
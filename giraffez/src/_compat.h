@@ -43,6 +43,19 @@
       } while (0)
 #endif
 
+// Dicts for rows are created large enough for every column up front
+// where the interpreter still exposes the presized constructor.
+#if PY_VERSION_HEX >= 0x030D0000
+  #define PyDict_NewPresized(n) PyDict_New()
+#else
+  #define PyDict_NewPresized(n) _PyDict_NewPresized(n)
+#endif
+
+// Python 2 returns -1 as a long when a thread cannot be started.
+#ifndef PYTHREAD_INVALID_THREAD_ID
+  #define PYTHREAD_INVALID_THREAD_ID ((unsigned long)-1)
+#endif
+
 #if PY_MAJOR_VERSION >= 3
   #define MOD_ERROR_VAL NULL
   #define MOD_SUCCESS_VAL(val) val
@@ -53,6 +66,7 @@
           ob = PyModule_Create(&moduledef);
 
   #define Py_TPFLAGS_HAVE_ITER 0
+  #define Py_TPFLAGS_HAVE_NEWBUFFER 0
   #define MOD_ERROR_VAL NULL
   #define PyStr_Check(ob) PyUnicode_Check(ob)
   #define _PyLong_Check(ob) PyLong_Check(ob)
@@ -67,6 +81,7 @@
 
   #define PyBytes_Check PyString_Check
   #define PyBytes_FromStringAndSize PyString_FromStringAndSize
+  #define PyUnicode_InternFromString PyString_InternFromString
 
   #define PyNumber_FloorDivide PyNumber_Divide
 
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "array.h"
+
+
+GiraffeArray* array_new(const char *format, const Py_ssize_t itemsize, const Py_ssize_t size) {
+    GiraffeArray *a;
+    if ((a = PyObject_New(GiraffeArray, &ArrayType)) == NULL) {
+        return NULL;
+    }
+    a->length = 0;
+    a->size = size > 0 ? size : 1;
+    a->itemsize = itemsize;
+    a->format = format;
+    a->exports = 0;
+    if ((a->data = (char*)calloc(a->size, itemsize)) == NULL) {
+        Py_DECREF(a);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return a;
+}
+
+int array_reserve(GiraffeArray *a, const Py_ssize_t n) {
+    Py_ssize_t size;
+    char *data;
+    if (a->length + n <= a->size) {
+        return 0;
+    }
+    if (a->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, "Cannot resize an array with exported buffers");
+        return -1;
+    }
+    size = a->size * 2;
+    while (size < a->length + n) {
+        size *= 2;
+    }
+    if ((data = (char*)realloc(a->data, size * a->itemsize)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    a->data = data;
+    a->size = size;
+    return 0;
+}
+
+void array_write(GiraffeArray *a, const void *data, const Py_ssize_t n) {
+    memcpy(a->data + a->length * a->itemsize, data, n * a->itemsize);
+    a->length += n;
+}
+
+void bitmap_set(unsigned char *bitmap, const size_t pos) {
+    bitmap[pos/8] |= (1 << (pos%8));
+}
+
+static void Array_dealloc(GiraffeArray *self) {
+    free(self->data);
+    self->data = NULL;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int Array_getbuffer(GiraffeArray *self, Py_buffer *view, int flags) {
+    if (view == NULL) {
+        PyErr_SetString(PyExc_BufferError, "NULL view in getbuffer");
+        return -1;
+    }
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Array is not writable");
+        return -1;
+    }
+    view->buf = self->data;
+    view->obj = (PyObject*)self;
+    view->len = self->length * self->itemsize;
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = NULL;
+    if ((flags & PyBUF_FORMAT) == PyBUF_FORMAT) {
+        view->format = (char*)self->format;
+    }
+    view->ndim = 1;
+    view->shape = NULL;
+    if ((flags & PyBUF_ND) == PyBUF_ND) {
+        view->shape = &self->length;
+    }
+    view->strides = NULL;
+    if ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) {
+        view->strides = &self->itemsize;
+    }
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    Py_INCREF(self);
+    self->exports++;
+    return 0;
+}
+
+static void Array_releasebuffer(GiraffeArray *self, Py_buffer *view) {
+    self->exports--;
+}
+
+static Py_ssize_t Array_length(GiraffeArray *self) {
+    return self->length;
+}
+
+static PyObject* Array_repr(GiraffeArray *self) {
+    return PyUnicode_FromFormat("<_teradata.Array format='%s' length=%zd>", self->format,
+        self->length);
+}
+
+static PyObject* Array_get_format(GiraffeArray *self, void *closure) {
+    return PyUnicode_FromString(self->format);
+}
+
+static PyObject* Array_get_itemsize(GiraffeArray *self, void *closure) {
+    return PyLong_FromSsize_t(self->itemsize);
+}
+
+static PyGetSetDef Array_getset[] = {
+    {"format", (getter)Array_get_format, NULL, "", NULL},
+    {"itemsize", (getter)Array_get_itemsize, NULL, "", NULL},
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods Array_as_sequence = {
+    (lenfunc)Array_length,                          /* sq_length */
+};
+
+static PyBufferProcs Array_as_buffer = {
+#if PY_MAJOR_VERSION < 3
+    0,                                              /* bf_getreadbuffer */
+    0,                                              /* bf_getwritebuffer */
+    0,                                              /* bf_getsegcount */
+    0,                                              /* bf_getcharbuffer */
+#endif
+    (getbufferproc)Array_getbuffer,                 /* bf_getbuffer */
+    (releasebufferproc)Array_releasebuffer,         /* bf_releasebuffer */
+};
+
+PyTypeObject ArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_teradata.Array",                              /* tp_name */
+    sizeof(GiraffeArray),                           /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    (destructor)Array_dealloc,                      /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    (reprfunc)Array_repr,                           /* tp_repr */
+    0,                                              /* tp_as_number */
+    &Array_as_sequence,                             /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    &Array_as_buffer,                               /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+    "Array objects",                                /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    0,                                              /* tp_iter */
+    0,                                              /* tp_iternext */
+    0,                                              /* tp_methods */
+    0,                                              /* tp_members */
+    Array_getset,                                   /* tp_getset */
+};
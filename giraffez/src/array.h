@@ -0,0 +1,51 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_ARRAY_H
+#define __GIRAFFEZ_ARRAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+
+
+// GiraffeArray is a contiguous, typed block of memory exposed to Python
+// through the buffer protocol. The format string follows the struct
+// module conventions so that memoryview, NumPy and Arrow can read the
+// values without copying them.
+typedef struct {
+    PyObject_HEAD
+    char       *data;
+    Py_ssize_t length;
+    Py_ssize_t size;
+    Py_ssize_t itemsize;
+    const char *format;
+    Py_ssize_t exports;
+} GiraffeArray;
+
+GiraffeArray* array_new(const char *format, const Py_ssize_t itemsize, const Py_ssize_t size);
+int           array_reserve(GiraffeArray *a, const Py_ssize_t n);
+void          array_write(GiraffeArray *a, const void *data, const Py_ssize_t n);
+
+void bitmap_set(unsigned char *bitmap, const size_t pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,490 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "columns.h"
+#include "convert.h"
+#include "encoder.h"
+#include "row.h"
+
+#include "arrow.h"
+
+
+#define ARROW_BUFFER(array, i) ((unsigned char*)(array)->buffers[i])
+#define ARROW_OFFSETS(array) ((int32_t*)(array)->buffers[1])
+
+// Physical layout of the Arrow array built for each column. Fixed-width
+// kinds use the validity and values buffers, variable-length kinds add an
+// int32 offsets buffer between them.
+enum ArrowColumnKinds {
+    ARROW_FIXED,
+    ARROW_DECIMAL,
+    ARROW_DATE,
+    ARROW_NUMBER,
+    ARROW_BINARY
+};
+
+static int arrow_column_kind(const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_BYTEINT:
+        case GD_SMALLINT:
+        case GD_INTEGER:
+        case GD_BIGINT:
+        case GD_FLOAT:
+        case GD_BYTE:
+            return ARROW_FIXED;
+        case GD_DECIMAL:
+            return ARROW_DECIMAL;
+        case GD_DATE:
+            return ARROW_DATE;
+        case GD_NUMBER:
+            return ARROW_NUMBER;
+        default:
+            return ARROW_BINARY;
+    }
+}
+
+static size_t arrow_column_width(const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            return sizeof(int8_t);
+        case GD_SMALLINT:
+            return sizeof(int16_t);
+        case GD_INTEGER:
+        case GD_DATE:
+            return sizeof(int32_t);
+        case GD_BIGINT:
+            return sizeof(int64_t);
+        case GD_FLOAT:
+            return sizeof(double);
+        case GD_DECIMAL:
+            return 2 * sizeof(uint64_t);
+        case GD_BYTE:
+            return column->Length;
+        default:
+            return 0;
+    }
+}
+
+static void arrow_column_format(const GiraffeColumn *column, char *buf, size_t n) {
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            snprintf(buf, n, "c");
+            break;
+        case GD_SMALLINT:
+            snprintf(buf, n, "s");
+            break;
+        case GD_INTEGER:
+            snprintf(buf, n, "i");
+            break;
+        case GD_BIGINT:
+            snprintf(buf, n, "l");
+            break;
+        case GD_FLOAT:
+            snprintf(buf, n, "g");
+            break;
+        case GD_DECIMAL:
+            // Teradata DECIMAL allows at most 38 digits which is also the
+            // limit of decimal128
+            snprintf(buf, n, "d:%d,%d", column->Precision > 0 ? column->Precision : 38,
+                column->Scale);
+            break;
+        case GD_DATE:
+            snprintf(buf, n, "tdD");
+            break;
+        case GD_BYTE:
+            snprintf(buf, n, "w:%d", (int)column->Length);
+            break;
+        case GD_VARBYTE:
+            snprintf(buf, n, "z");
+            break;
+        default:
+            // NUMBER has a per-value scale and cannot be represented as
+            // decimal128 with a fixed scale so it is exported as utf8
+            // along with CHAR, VARCHAR, TIME and TIMESTAMP.
+            snprintf(buf, n, "u");
+    }
+}
+
+// Teradata stores dates as (year - 1900) * 10000 + month * 100 + day.
+// Arrow date32 is the number of days since the UNIX epoch.
+static int32_t arrow_date32(int32_t l) {
+    int32_t year, month, day, era, yoe, doy, doe;
+    l += 19000000;
+    year = l / 10000;
+    month = (l % 10000) / 100;
+    day = l % 100;
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Sign-extends a Teradata DECIMAL of any width into a 128-bit
+// little-endian integer, which is the decimal128 memory layout.
+static void arrow_decimal128(unsigned char **data, const uint64_t column_length, unsigned char *dst) {
+    int8_t b; int16_t h; int32_t l; int64_t q;
+    uint64_t lo;
+    int64_t hi;
+    switch (column_length) {
+        case 1:
+            unpack_int8_t(data, &b);
+            q = b;
+            break;
+        case 2:
+            unpack_int16_t(data, &h);
+            q = h;
+            break;
+        case 4:
+            unpack_int32_t(data, &l);
+            q = l;
+            break;
+        case 8:
+            unpack_int64_t(data, &q);
+            break;
+        default:
+            unpack_uint64_t(data, &lo);
+            unpack_int64_t(data, &hi);
+            memcpy(dst, &lo, sizeof(uint64_t));
+            memcpy(dst + sizeof(uint64_t), &hi, sizeof(int64_t));
+            return;
+    }
+    lo = (uint64_t)q;
+    hi = q < 0 ? -1 : 0;
+    memcpy(dst, &lo, sizeof(uint64_t));
+    memcpy(dst + sizeof(uint64_t), &hi, sizeof(int64_t));
+}
+
+static void arrow_fixed(unsigned char **data, const GiraffeColumn *column, unsigned char *dst) {
+    int8_t b; int16_t h; int32_t l; int64_t q; double d;
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            unpack_int8_t(data, &b);
+            memcpy(dst, &b, sizeof(b));
+            break;
+        case GD_SMALLINT:
+            unpack_int16_t(data, &h);
+            memcpy(dst, &h, sizeof(h));
+            break;
+        case GD_INTEGER:
+            unpack_int32_t(data, &l);
+            memcpy(dst, &l, sizeof(l));
+            break;
+        case GD_BIGINT:
+            unpack_int64_t(data, &q);
+            memcpy(dst, &q, sizeof(q));
+            break;
+        case GD_FLOAT:
+            unpack_float(data, &d);
+            memcpy(dst, &d, sizeof(d));
+            break;
+        default:
+            memcpy(dst, *data, column->Length);
+            *data += column->Length;
+    }
+}
+
+static int arrow_append(struct ArrowArray *array, size_t *size, const uint32_t row,
+        const void *src, const size_t n) {
+    int32_t *offsets = ARROW_OFFSETS(array);
+    size_t length = offsets[row+1];
+    void *values;
+    if (length + n > *size) {
+        while (length + n > *size) {
+            *size *= 2;
+        }
+        if ((values = realloc((void*)array->buffers[2], *size)) == NULL) {
+            return -1;
+        }
+        array->buffers[2] = values;
+    }
+    memcpy(ARROW_BUFFER(array, 2) + length, src, n);
+    offsets[row+1] += (int32_t)n;
+    return 0;
+}
+
+static void arrow_schema_release(struct ArrowSchema *schema) {
+    int64_t i;
+    for (i=0; schema->children != NULL && i<schema->n_children; i++) {
+        if (schema->children[i] == NULL) {
+            continue;
+        }
+        if (schema->children[i]->release != NULL) {
+            schema->children[i]->release(schema->children[i]);
+        }
+        free(schema->children[i]);
+    }
+    free(schema->children);
+    free((char*)schema->format);
+    free((char*)schema->name);
+    schema->release = NULL;
+}
+
+static struct ArrowSchema* arrow_schema_new(const char *format, const char *name,
+        const int64_t n_children) {
+    struct ArrowSchema *schema;
+    if ((schema = (struct ArrowSchema*)calloc(1, sizeof(struct ArrowSchema))) == NULL) {
+        return NULL;
+    }
+    schema->format = strdup(format);
+    schema->name = strdup(name);
+    schema->flags = ARROW_FLAG_NULLABLE;
+    schema->n_children = n_children;
+    schema->release = arrow_schema_release;
+    if (n_children > 0) {
+        schema->children = (struct ArrowSchema**)calloc(n_children, sizeof(struct ArrowSchema*));
+    }
+    if (schema->format == NULL || schema->name == NULL || (n_children > 0 && schema->children == NULL)) {
+        arrow_schema_release(schema);
+        free(schema);
+        return NULL;
+    }
+    return schema;
+}
+
+static void arrow_array_release(struct ArrowArray *array) {
+    int64_t i;
+    for (i=0; array->children != NULL && i<array->n_children; i++) {
+        if (array->children[i] == NULL) {
+            continue;
+        }
+        if (array->children[i]->release != NULL) {
+            array->children[i]->release(array->children[i]);
+        }
+        free(array->children[i]);
+    }
+    free(array->children);
+    for (i=0; array->buffers != NULL && i<array->n_buffers; i++) {
+        free((void*)array->buffers[i]);
+    }
+    free(array->buffers);
+    array->release = NULL;
+}
+
+static struct ArrowArray* arrow_array_new(const int64_t length, const int64_t n_buffers,
+        const int64_t n_children) {
+    struct ArrowArray *array;
+    if ((array = (struct ArrowArray*)calloc(1, sizeof(struct ArrowArray))) == NULL) {
+        return NULL;
+    }
+    array->length = length;
+    array->n_buffers = n_buffers;
+    array->n_children = n_children;
+    array->release = arrow_array_release;
+    array->buffers = (const void**)calloc(n_buffers, sizeof(void*));
+    if (n_children > 0) {
+        array->children = (struct ArrowArray**)calloc(n_children, sizeof(struct ArrowArray*));
+    }
+    if (array->buffers == NULL || (n_children > 0 && array->children == NULL)) {
+        arrow_array_release(array);
+        free(array);
+        return NULL;
+    }
+    return array;
+}
+
+struct ArrowSchema* arrow_schema_from_columns(const GiraffeColumns *columns) {
+    struct ArrowSchema *schema;
+    GiraffeColumn *column;
+    size_t i;
+    char format[32];
+    if ((schema = arrow_schema_new("+s", "", columns->length)) == NULL) {
+        return NULL;
+    }
+    // The struct itself is never null, only its fields
+    schema->flags = 0;
+    for (i=0; i<columns->length; i++) {
+        column = &columns->array[i];
+        arrow_column_format(column, format, sizeof(format));
+        if ((schema->children[i] = arrow_schema_new(format, column->Title, 0)) == NULL) {
+            arrow_schema_release(schema);
+            free(schema);
+            return NULL;
+        }
+    }
+    return schema;
+}
+
+struct ArrowArray* arrow_array_from_buffer(const GiraffeColumns *columns, unsigned char **data,
+        const uint32_t length) {
+    struct ArrowArray *batch;
+    struct ArrowArray *child;
+    GiraffeColumn *column;
+    unsigned char *row;
+    size_t *sizes = NULL;
+    size_t i, width;
+    uint32_t nrows, j;
+    uint16_t row_length, H;
+    int32_t l;
+    int kind, n, nulls;
+    char item[BUFFER_ITEM_SIZE];
+    nrows = teradata_buffer_count_rows(*data, length);
+    if ((batch = arrow_array_new(nrows, 1, columns->length)) == NULL) {
+        return NULL;
+    }
+    if ((sizes = (size_t*)calloc(columns->length, sizeof(size_t))) == NULL) {
+        goto error;
+    }
+    for (i=0; i<columns->length; i++) {
+        column = &columns->array[i];
+        kind = arrow_column_kind(column);
+        if (kind == ARROW_NUMBER || kind == ARROW_BINARY) {
+            if ((child = arrow_array_new(nrows, 3, 0)) == NULL) {
+                goto error;
+            }
+            batch->children[i] = child;
+            sizes[i] = nrows * (column->Length > 0 ? column->Length : 1) + 1;
+            child->buffers[1] = calloc(nrows+1, sizeof(int32_t));
+            child->buffers[2] = malloc(sizes[i]);
+            if (child->buffers[2] == NULL) {
+                goto error;
+            }
+        } else {
+            if ((child = arrow_array_new(nrows, 2, 0)) == NULL) {
+                goto error;
+            }
+            batch->children[i] = child;
+            child->buffers[1] = calloc(nrows+1, arrow_column_width(column));
+        }
+        child->buffers[0] = calloc(nrows/8+1, 1);
+        if (child->buffers[0] == NULL || child->buffers[1] == NULL) {
+            goto error;
+        }
+    }
+    for (j=0; j<nrows; j++) {
+        row_length = 0;
+        unpack_uint16_t(data, &row_length);
+        row = *data;
+        nulls = indicator_set((GiraffeColumns*)columns, data);
+        for (i=0; i<columns->length; i++) {
+            column = &columns->array[i];
+            child = batch->children[i];
+            kind = arrow_column_kind(column);
+            width = arrow_column_width(column);
+            if (kind == ARROW_NUMBER || kind == ARROW_BINARY) {
+                ARROW_OFFSETS(child)[j+1] = ARROW_OFFSETS(child)[j];
+            }
+            if (nulls && indicator_is_null(columns->buffer, i)) {
+                *data += column->NullLength;
+                child->null_count++;
+                continue;
+            }
+            ARROW_BUFFER(child, 0)[j/8] |= (1 << (j%8));
+            switch (kind) {
+                case ARROW_FIXED:
+                    arrow_fixed(data, column, ARROW_BUFFER(child, 1) + j * width);
+                    break;
+                case ARROW_DECIMAL:
+                    arrow_decimal128(data, column->Length, ARROW_BUFFER(child, 1) + j * width);
+                    break;
+                case ARROW_DATE:
+                    unpack_int32_t(data, &l);
+                    l = arrow_date32(l);
+                    memcpy(ARROW_BUFFER(child, 1) + j * width, &l, sizeof(l));
+                    break;
+                case ARROW_NUMBER:
+                    if ((n = teradata_number_to_cstring(data, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting number");
+                        goto error;
+                    }
+                    if (arrow_append(child, &sizes[i], j, item, n) != 0) {
+                        goto error;
+                    }
+                    break;
+                default:
+                    if (column->GDType == GD_VARCHAR || column->GDType == GD_VARBYTE) {
+                        unpack_uint16_t(data, &H);
+                        n = H;
+                    } else {
+                        n = (int)column->Length;
+                    }
+                    if (arrow_append(child, &sizes[i], j, *data, n) != 0) {
+                        goto error;
+                    }
+                    *data += n;
+            }
+        }
+        *data = row + row_length;
+    }
+    free(sizes);
+    return batch;
+error:
+    if (!PyErr_Occurred()) {
+        PyErr_NoMemory();
+    }
+    free(sizes);
+    arrow_array_release(batch);
+    free(batch);
+    return NULL;
+}
+
+static void arrow_schema_capsule_free(PyObject *capsule) {
+    struct ArrowSchema *schema;
+    if ((schema = (struct ArrowSchema*)PyCapsule_GetPointer(capsule, ARROW_SCHEMA_CAPSULE)) == NULL) {
+        PyErr_Clear();
+        return;
+    }
+    // A consumer that imported the schema has moved it and set release
+    // to NULL, otherwise it is still owned here.
+    if (schema->release != NULL) {
+        schema->release(schema);
+    }
+    free(schema);
+}
+
+static void arrow_array_capsule_free(PyObject *capsule) {
+    struct ArrowArray *array;
+    if ((array = (struct ArrowArray*)PyCapsule_GetPointer(capsule, ARROW_ARRAY_CAPSULE)) == NULL) {
+        PyErr_Clear();
+        return;
+    }
+    if (array->release != NULL) {
+        array->release(array);
+    }
+    free(array);
+}
+
+PyObject* teradata_buffer_to_arrow(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
+    struct ArrowSchema *schema;
+    struct ArrowArray *array;
+    PyObject *schema_capsule;
+    PyObject *array_capsule;
+    if (e->Columns == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking to Arrow");
+        return NULL;
+    }
+    if ((schema = arrow_schema_from_columns(e->Columns)) == NULL) {
+        return PyErr_NoMemory();
+    }
+    if ((schema_capsule = PyCapsule_New(schema, ARROW_SCHEMA_CAPSULE, arrow_schema_capsule_free)) == NULL) {
+        arrow_schema_release(schema);
+        free(schema);
+        return NULL;
+    }
+    if ((array = arrow_array_from_buffer(e->Columns, data, length)) == NULL) {
+        Py_DECREF(schema_capsule);
+        return NULL;
+    }
+    if ((array_capsule = PyCapsule_New(array, ARROW_ARRAY_CAPSULE, arrow_array_capsule_free)) == NULL) {
+        arrow_array_release(array);
+        free(array);
+        Py_DECREF(schema_capsule);
+        return NULL;
+    }
+    return Py_BuildValue("((NN))", schema_capsule, array_capsule);
+}
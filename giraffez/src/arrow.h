@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_ARROW_H
+#define __GIRAFFEZ_ARROW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include "columns.h"
+#include "encoder.h"
+
+
+// The Arrow C Data Interface structs are ABI stable and meant to be copied
+// into projects rather than linked against, which keeps pyarrow (or any
+// other Arrow implementation) an optional runtime dependency:
+// https://arrow.apache.org/docs/format/CDataInterface.html
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema*);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray*);
+    void *private_data;
+};
+
+#endif
+
+#define ARROW_SCHEMA_CAPSULE "arrow_schema"
+#define ARROW_ARRAY_CAPSULE  "arrow_array"
+
+struct ArrowSchema* arrow_schema_from_columns(const GiraffeColumns *columns);
+struct ArrowArray*  arrow_array_from_buffer(const GiraffeColumns *columns, unsigned char **data,
+    const uint32_t length);
+
+PyObject* teradata_buffer_to_arrow(const TeradataEncoder *e, unsigned char **data, const uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
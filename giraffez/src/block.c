@@ -0,0 +1,370 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "columns.h"
+#include "convert.h"
+#include "encoder.h"
+#include "row.h"
+
+#include "block.h"
+
+
+DecodedBlock* decoded_block_new(const size_t rows, const size_t width) {
+    DecodedBlock *b;
+    if ((b = (DecodedBlock*)malloc(sizeof(DecodedBlock))) == NULL) {
+        return NULL;
+    }
+    b->rows = rows;
+    b->width = width;
+    b->text = NULL;
+    b->text_length = 0;
+    b->text_size = 0;
+    if ((b->values = (DecodedValue*)malloc((rows * width + 1) * sizeof(DecodedValue))) == NULL) {
+        free(b);
+        return NULL;
+    }
+    return b;
+}
+
+void decoded_block_free(DecodedBlock *b) {
+    if (b == NULL) {
+        return;
+    }
+    free(b->values);
+    free(b->text);
+    free(b);
+}
+
+static int block_write_text(DecodedBlock *b, DecodedValue *value, const char *s, const int n) {
+    char *text;
+    size_t size;
+    if (b->text_length + n > b->text_size) {
+        size = b->text_size > 0 ? b->text_size : BUFFER_ITEM_SIZE;
+        while (b->text_length + n > size) {
+            size *= 2;
+        }
+        if ((text = (char*)realloc(b->text, size)) == NULL) {
+            return DECODE_NO_MEMORY;
+        }
+        b->text = text;
+        b->text_size = size;
+    }
+    memcpy(b->text + b->text_length, s, n);
+    value->v.offset = b->text_length;
+    value->Length = (uint32_t)n;
+    b->text_length += n;
+    return DECODE_OK;
+}
+
+// Stores the unscaled value hi:lo of a DECIMAL or NUMBER as an int64 when
+// it fits, which is nearly always, and as its digits otherwise.
+static int block_write_int128(DecodedBlock *b, DecodedValue *value, const uint64_t hi,
+        const uint64_t lo) {
+    char item[BUFFER_ITEM_SIZE];
+    if (hi == ((int64_t)lo < 0 ? ~0ULL : 0)) {
+        value->Kind = VALUE_INT64;
+        value->v.q = (int64_t)lo;
+        return DECODE_OK;
+    }
+    value->Kind = VALUE_DECIMAL;
+    return block_write_text(b, value, item, format_int128(item, hi, lo));
+}
+
+// Parses a single value at *data into value. This must not use the Python
+// API as it runs with the GIL released.
+static int block_decode_value(DecodedBlock *b, const uint16_t opcode, const GiraffeColumn *column,
+        unsigned char **data, DecodedValue *value) {
+    int8_t b8;
+    int16_t h;
+    int32_t l;
+    uint16_t H;
+    uint64_t hi, lo;
+    int n;
+    char item[BUFFER_ITEM_SIZE];
+    value->Opcode = opcode;
+    switch (opcode) {
+        case OP_BYTEINT:
+            unpack_int8_t(data, &b8);
+            value->Kind = VALUE_INT64;
+            value->v.q = b8;
+            return DECODE_OK;
+        case OP_SMALLINT:
+            unpack_int16_t(data, &h);
+            value->Kind = VALUE_INT64;
+            value->v.q = h;
+            return DECODE_OK;
+        case OP_INTEGER:
+            unpack_int32_t(data, &l);
+            value->Kind = VALUE_INT64;
+            value->v.q = l;
+            return DECODE_OK;
+        case OP_BIGINT:
+            unpack_int64_t(data, &value->v.q);
+            value->Kind = VALUE_INT64;
+            return DECODE_OK;
+        case OP_FLOAT:
+            unpack_float(data, &value->v.d);
+            value->Kind = VALUE_DOUBLE;
+            return DECODE_OK;
+        case OP_DECIMAL_AS_FLOAT:
+            if (teradata_decimal_to_double(data, column->Length, column->Scale, &value->v.d) == 0) {
+                value->Kind = VALUE_DOUBLE;
+                return DECODE_OK;
+            }
+            // larger values are kept as text and parsed with the GIL held
+            /* FALLTHROUGH */
+        case OP_DECIMAL_AS_STRING:
+        case OP_DECIMAL_AS_GIRAFFEZ_DECIMAL:
+            if ((n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
+                return DECODE_DECIMAL_ERROR;
+            }
+            value->Kind = VALUE_DECIMAL;
+            return block_write_text(b, value, item, n);
+        case OP_DECIMAL_AS_SCALED_INT:
+            if (teradata_decimal_to_int128(data, column->Length, &hi, &lo) != 0) {
+                return DECODE_DECIMAL_ERROR;
+            }
+            return block_write_int128(b, value, hi, lo);
+        case OP_NUMBER_AS_FLOAT:
+            if (teradata_number_to_double(data, &value->v.d) == 0) {
+                value->Kind = VALUE_DOUBLE;
+                return DECODE_OK;
+            }
+            // larger values are kept as text and parsed with the GIL held
+            /* FALLTHROUGH */
+        case OP_NUMBER_AS_STRING:
+        case OP_NUMBER_AS_GIRAFFEZ_DECIMAL:
+            if ((n = teradata_number_to_cstring(data, item)) < 0) {
+                return DECODE_NUMBER_ERROR;
+            }
+            value->Kind = VALUE_DECIMAL;
+            return block_write_text(b, value, item, n);
+        case OP_NUMBER_AS_SCALED_INT:
+            if (teradata_number_to_int128(data, column->Scale, &hi, &lo) != 0) {
+                return DECODE_SCALE_ERROR;
+            }
+            return block_write_int128(b, value, hi, lo);
+        case OP_DATE_AS_STRING:
+            if ((n = teradata_date_to_cstring(data, item)) < 0) {
+                return DECODE_DATE_ERROR;
+            }
+            value->Kind = VALUE_FORMATTED;
+            return block_write_text(b, value, item, n);
+        case OP_CHAR:
+        case OP_CHAR_TRIMMED:
+            value->Kind = VALUE_TEXT;
+            value->v.s = *data;
+            value->Length = (uint32_t)teradata_char_length(*data, column->Length, column->FormatLength,
+                opcode == OP_CHAR_TRIMMED);
+            *data += column->Length;
+            return DECODE_OK;
+        case OP_TIME_AS_STRING:
+        case OP_TIMESTAMP_AS_STRING:
+            value->Kind = VALUE_TEXT;
+            value->v.s = *data;
+            value->Length = (uint32_t)column->Length;
+            *data += column->Length;
+            return DECODE_OK;
+        case OP_BYTE:
+            value->Kind = VALUE_BYTES;
+            value->v.s = *data;
+            value->Length = (uint32_t)column->Length;
+            *data += column->Length;
+            return DECODE_OK;
+        case OP_VARCHAR:
+        case OP_VARBYTE:
+            unpack_uint16_t(data, &H);
+            value->Kind = opcode == OP_VARCHAR ? VALUE_TEXT : VALUE_BYTES;
+            value->v.s = *data;
+            value->Length = H;
+            *data += H;
+            return DECODE_OK;
+        default:
+            value->Kind = VALUE_DEFERRED;
+            value->v.s = *data;
+            column_skip(data, column);
+            return DECODE_OK;
+    }
+}
+
+// Parses the decoded columns of the rows, each given by a pointer to its
+// length prefix (see teradata_buffer_index_rows), following the decode
+// plan of the encoder. Only the plan and the columns are read from the
+// encoder, and no Python objects are touched, so this is run with the GIL
+// released. Returns DECODE_OK or the status of the first failure.
+int decoded_block_fill(DecodedBlock *b, const TeradataEncoder *e, unsigned char **rows) {
+    const DecodeOp *op;
+    const DecodeOp *end;
+    GiraffeColumn *column;
+    DecodedValue *out;
+    unsigned char *row;
+    unsigned char *data;
+    size_t i, k;
+    int status;
+    end = e->Plan->ops + e->Plan->length;
+    for (i=0; i<b->rows; i++) {
+        row = rows[i] + sizeof(uint16_t);
+        data = row + e->Columns->header_length;
+        out = b->values + i * b->width;
+        for (op=e->Plan->ops; op<end; op++) {
+            if (op->Opcode == OP_SKIP_FIXED) {
+                data += op->Length;
+                continue;
+            }
+            for (k=op->Column; k<op->Column+op->Count; k++) {
+                column = &e->Columns->array[k];
+                if (indicator_is_null(row, k)) {
+                    data += column->NullLength;
+                    if (op->Opcode != OP_SKIP) {
+                        out[op->Item + k - op->Column].Kind = VALUE_NULL;
+                    }
+                } else if (op->Opcode == OP_SKIP) {
+                    column_skip(&data, column);
+                } else {
+                    status = block_decode_value(b, op->Opcode, column, &data, &out[op->Item + k - op->Column]);
+                    if (status != DECODE_OK) {
+                        return status;
+                    }
+                }
+            }
+        }
+    }
+    return DECODE_OK;
+}
+
+void decoded_block_set_error(const int status) {
+    switch (status) {
+        case DECODE_NO_MEMORY:
+            PyErr_NoMemory();
+            break;
+        case DECODE_NUMBER_ERROR:
+            PyErr_SetString(EncoderError, "Unexpected error while converting number");
+            break;
+        case DECODE_DATE_ERROR:
+            PyErr_SetString(EncoderError, "Unexpected error while converting date");
+            break;
+        case DECODE_SCALE_ERROR:
+            PyErr_SetString(EncoderError, "NUMBER value cannot be represented at the scale of its column");
+            break;
+        default:
+            PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+    }
+}
+
+int decode_job_init(DecodeJob *job, const TeradataEncoder *e, const unsigned char *data,
+        const uint32_t length) {
+    int n;
+    job->encoder = e;
+    job->index = NULL;
+    job->block = NULL;
+    job->status = DECODE_OK;
+    if ((job->data = (unsigned char*)malloc(length + 1)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(job->data, data, length);
+    if ((n = teradata_buffer_index_rows(e, job->data, length, &job->index)) < 0) {
+        goto error;
+    }
+    if ((job->block = decoded_block_new(n, e->Plan->width)) == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    return 0;
+error:
+    decode_job_clear(job);
+    return -1;
+}
+
+void decode_job_run(void *arg) {
+    DecodeJob *job = (DecodeJob*)arg;
+    job->status = decoded_block_fill(job->block, job->encoder, job->index);
+}
+
+void decode_job_clear(DecodeJob *job) {
+    decoded_block_free(job->block);
+    free(job->index);
+    free(job->data);
+    job->block = NULL;
+    job->index = NULL;
+    job->data = NULL;
+}
+
+static PyObject* deferred_to_pyobject(const TeradataEncoder *e, const DecodedValue *value,
+        const GiraffeColumn *column) {
+    unsigned char *data = value->v.s;
+    switch (value->Opcode) {
+        case OP_DATE_AS_GIRAFFE_TYPES:
+            return teradata_date_to_giraffez_date(&data);
+        case OP_TIME_AS_GIRAFFE_TYPES:
+            return teradata_time_to_giraffez_time(&data, column->Length);
+        case OP_TIMESTAMP_AS_GIRAFFE_TYPES:
+            return teradata_ts_to_giraffez_ts(&data, column->Length);
+        case OP_CACHED:
+            return teradata_cached_to_pyobject(e, &data, column, e->Plan->caches[column - e->Columns->array]);
+        default:
+            return teradata_char_to_pystring(&data, column->Length);
+    }
+}
+
+// Creates the objects of a row of the block, storing a new reference for
+// each decoded column into items. Returns -1 with an exception set, in
+// which case items holds no references.
+int decoded_block_items(const TeradataEncoder *e, const DecodedBlock *b, const size_t row,
+        PyObject **items) {
+    const DecodedValue *value;
+    const GiraffeColumn *column;
+    PyObject *item;
+    size_t i;
+    for (i=0; i<b->width; i++) {
+        value = &b->values[row * b->width + i];
+        switch (value->Kind) {
+            case VALUE_NULL:
+                Py_INCREF(e->NullValue);
+                item = e->NullValue;
+                break;
+            case VALUE_INT64:
+                item = PyLong_FromLongLong(value->v.q);
+                break;
+            case VALUE_DOUBLE:
+                item = PyFloat_FromDouble(value->v.d);
+                break;
+            case VALUE_TEXT:
+                item = utf8_to_pystring((char*)value->v.s, value->Length);
+                break;
+            case VALUE_BYTES:
+                item = PyBytes_FromStringAndSize((char*)value->v.s, value->Length);
+                break;
+            case VALUE_FORMATTED:
+                item = utf8_to_pystring(b->text + value->v.offset, value->Length);
+                break;
+            case VALUE_DECIMAL:
+                item = e->UnpackDecimalFunc(b->text + value->v.offset, value->Length);
+                break;
+            default:
+                column = &e->Columns->array[e->Plan->columns[i]];
+                item = deferred_to_pyobject(e, value, column);
+        }
+        if ((items[i] = item) == NULL) {
+            while (i > 0) {
+                Py_CLEAR(items[--i]);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
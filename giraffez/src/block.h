@@ -0,0 +1,105 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_BLOCK_H
+#define __GIRAFFEZ_BLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include "columns.h"
+#include "encoder.h"
+
+
+enum DecodedKind {
+    VALUE_NULL = 0,
+    VALUE_INT64,
+    VALUE_DOUBLE,
+    VALUE_TEXT,
+    VALUE_BYTES,
+    VALUE_FORMATTED,
+    VALUE_DECIMAL,
+    VALUE_DEFERRED
+};
+
+enum DecodeStatus {
+    DECODE_OK = 0,
+    DECODE_NO_MEMORY,
+    DECODE_DECIMAL_ERROR,
+    DECODE_NUMBER_ERROR,
+    DECODE_DATE_ERROR,
+    DECODE_SCALE_ERROR
+};
+
+// A column value parsed from the wire without any Python objects. Numbers
+// are held as machine types, TEXT and BYTES refer to Length bytes of the
+// block at s, FORMATTED and DECIMAL to Length bytes of the block text at
+// offset. DEFERRED values, such as those converted to giraffez types, are
+// converted by their Opcode from the wire value at s.
+typedef struct DecodedValue {
+    uint16_t Kind;
+    uint16_t Opcode;
+    uint32_t Length;
+    union {
+        int64_t       q;
+        double        d;
+        size_t        offset;
+        unsigned char *s;
+    } v;
+} DecodedValue;
+
+// The values of the decoded columns of every row of a block, row by row,
+// along with the text of the values that had to be formatted. A block
+// refers to the buffer it was decoded from, which must outlive it.
+typedef struct DecodedBlock {
+    size_t       rows;
+    size_t       width;
+    DecodedValue *values;
+    char         *text;
+    size_t       text_length;
+    size_t       text_size;
+} DecodedBlock;
+
+// A buffer decoded on a worker thread. The buffer is copied, as the one
+// received from the server is reused for the next buffer, and its rows
+// are indexed and filtered before the job is run.
+typedef struct DecodeJob {
+    const TeradataEncoder *encoder;
+    unsigned char         *data;
+    unsigned char         **index;
+    DecodedBlock          *block;
+    int                   status;
+} DecodeJob;
+
+DecodedBlock* decoded_block_new(const size_t rows, const size_t width);
+int           decoded_block_fill(DecodedBlock *b, const TeradataEncoder *e, unsigned char **rows);
+int           decoded_block_items(const TeradataEncoder *e, const DecodedBlock *b, const size_t row,
+    PyObject **items);
+void          decoded_block_set_error(const int status);
+void          decoded_block_free(DecodedBlock *b);
+
+int  decode_job_init(DecodeJob *job, const TeradataEncoder *e, const unsigned char *data,
+    const uint32_t length);
+void decode_job_run(void *job);
+void decode_job_clear(DecodeJob *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
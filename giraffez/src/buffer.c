@@ -16,6 +16,7 @@
 
 #include "buffer.h"
 #include "common.h"
+#include "convert.h"
 
 
 buffer_t* buffer_new(int buffer_size) {
@@ -23,16 +24,55 @@ buffer_t* buffer_new(int buffer_size) {
     b = (buffer_t*)malloc(sizeof(buffer_t));
     b->length = 0;
     b->pos = 0;
+    b->size = buffer_size;
     b->data = malloc(sizeof(char) * buffer_size);
     return b;
 }
 
+// Grows the buffer, when needed, so that at least n more bytes can be
+// written. Returns -1 when the memory cannot be allocated.
+int buffer_reserve(buffer_t *b, size_t n) {
+    char *data;
+    size_t size;
+    if (b->length + n <= b->size) {
+        return 0;
+    }
+    size = b->size * 2 > b->length + n ? b->size * 2 : b->length + n;
+    if ((data = (char*)realloc(b->data, size)) == NULL) {
+        return -1;
+    }
+    b->data = data;
+    b->size = size;
+    return 0;
+}
+
 void buffer_write(buffer_t *b, char *data, int length) {
     memcpy(b->data+b->pos, data, length);
     b->pos += length;
     b->length += length;
 }
 
+// Writes the decimal digits of v, without going through printf.
+void buffer_write_int64(buffer_t *b, const int64_t v) {
+    int length = format_int64(b->data+b->pos, v);
+    b->pos += length;
+    b->length += length;
+}
+
+// Writes the decimal digits of the 128-bit two's complement integer hi:lo.
+void buffer_write_int128(buffer_t *b, const uint64_t hi, const uint64_t lo) {
+    int length = format_int128(b->data+b->pos, hi, lo);
+    b->pos += length;
+    b->length += length;
+}
+
+// Writes the shortest text that reads back as exactly v.
+void buffer_write_double(buffer_t *b, const double v, const int add_dot_0) {
+    int length = format_double(b->data+b->pos, v, add_dot_0);
+    b->pos += length;
+    b->length += length;
+}
+
 void buffer_writef(buffer_t *b, const char *fmt, ...) {
     int length;
     va_list vargs;
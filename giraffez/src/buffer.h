@@ -27,11 +27,16 @@ extern "C" {
 typedef struct buffer_t {
     size_t length;
     size_t pos;
+    size_t size;
     char   *data;
 } buffer_t;
 
 buffer_t* buffer_new(int buffer_size);
+int       buffer_reserve(buffer_t *b, size_t n);
 void      buffer_write(buffer_t *b, char *data, int length);
+void      buffer_write_int64(buffer_t *b, const int64_t v);
+void      buffer_write_int128(buffer_t *b, const uint64_t hi, const uint64_t lo);
+void      buffer_write_double(buffer_t *b, const double v, const int add_dot_0);
 void      buffer_reset(buffer_t *b, size_t n);
 void      buffer_writef(buffer_t *b, const char *fmt, ...);
 
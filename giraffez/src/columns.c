@@ -42,6 +42,8 @@ GiraffeColumn* column_new() {
     column->FormatLength = 0;
     column->NullLength = 0;
     column->SafeName = NULL;
+    column->Offset = 0;
+    column->Key = NULL;
     return column;
 }
 
@@ -50,6 +52,8 @@ void columns_init(GiraffeColumns *c, size_t initial_size) {
     c->length = 0;
     c->size = initial_size;
     c->header_length = 0;
+    c->fixed_columns = 0;
+    c->fixed_length = 0;
     c->raw = (RawStatementInfo*)malloc(sizeof(RawStatementInfo));
     c->raw->data = NULL;
     c->raw->length = 0;
@@ -84,9 +88,22 @@ void columns_append(GiraffeColumns *c, GiraffeColumn element) {
         element.Title = safe_name(tmp);
         free(tmp);
     }
+    // A title that cannot be decoded is left without a key and reported
+    // when a row is decoded as a dict.
+    if ((element.Key = PyUnicode_InternFromString(element.Title)) == NULL) {
+        PyErr_Clear();
+    }
     if (element.GDType == GD_CHAR && element.Format != NULL) {
         element.FormatLength = format_length(element.Format);
     }
+    element.Offset = 0;
+    if (c->fixed_columns == c->length) {
+        element.Offset = c->fixed_length;
+        if (column_is_fixed(&element)) {
+            c->fixed_columns++;
+            c->fixed_length += element.Length;
+        }
+    }
     c->array[c->length++] = element;
     c->header_length = (int)ceil(c->length/8.0);
     c->buffer = (unsigned char*)realloc(c->buffer, c->header_length * sizeof(unsigned char));
@@ -106,6 +123,7 @@ void columns_free(GiraffeColumns *c) {
         free(column->Default);
         free(column->Nullable);
         free(column->SafeName);
+        Py_XDECREF(column->Key);
     }
     free(c->array);
     free(c->buffer);
@@ -114,54 +132,127 @@ void columns_free(GiraffeColumns *c) {
     c->length = c->size = 0;
 }
 
-void indicator_set(GiraffeColumns *columns, unsigned char **data) {
+// Returns a deep copy of the columns, for objects that need the columns to
+// outlive the encoder they were decoded with.
+GiraffeColumns* columns_copy(const GiraffeColumns *c) {
+    GiraffeColumns *copy;
+    GiraffeColumn *column;
     size_t i;
-    static const unsigned char reverse_lookup[256] = {
-        0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0,
-        0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
-        0x08, 0x88, 0x48, 0xc8, 0x28, 0xa8, 0x68, 0xe8,
-        0x18, 0x98, 0x58, 0xd8, 0x38, 0xb8, 0x78, 0xf8,
-        0x04, 0x84, 0x44, 0xc4, 0x24, 0xa4, 0x64, 0xe4,
-        0x14, 0x94, 0x54, 0xd4, 0x34, 0xb4, 0x74, 0xf4,
-        0x0c, 0x8c, 0x4c, 0xcc, 0x2c, 0xac, 0x6c, 0xec,
-        0x1c, 0x9c, 0x5c, 0xdc, 0x3c, 0xbc, 0x7c, 0xfc,
-        0x02, 0x82, 0x42, 0xc2, 0x22, 0xa2, 0x62, 0xe2,
-        0x12, 0x92, 0x52, 0xd2, 0x32, 0xb2, 0x72, 0xf2,
-        0x0a, 0x8a, 0x4a, 0xca, 0x2a, 0xaa, 0x6a, 0xea,
-        0x1a, 0x9a, 0x5a, 0xda, 0x3a, 0xba, 0x7a, 0xfa,
-        0x06, 0x86, 0x46, 0xc6, 0x26, 0xa6, 0x66, 0xe6,
-        0x16, 0x96, 0x56, 0xd6, 0x36, 0xb6, 0x76, 0xf6,
-        0x0e, 0x8e, 0x4e, 0xce, 0x2e, 0xae, 0x6e, 0xee,
-        0x1e, 0x9e, 0x5e, 0xde, 0x3e, 0xbe, 0x7e, 0xfe,
-        0x01, 0x81, 0x41, 0xc1, 0x21, 0xa1, 0x61, 0xe1,
-        0x11, 0x91, 0x51, 0xd1, 0x31, 0xb1, 0x71, 0xf1,
-        0x09, 0x89, 0x49, 0xc9, 0x29, 0xa9, 0x69, 0xe9,
-        0x19, 0x99, 0x59, 0xd9, 0x39, 0xb9, 0x79, 0xf9,
-        0x05, 0x85, 0x45, 0xc5, 0x25, 0xa5, 0x65, 0xe5,
-        0x15, 0x95, 0x55, 0xd5, 0x35, 0xb5, 0x75, 0xf5,
-        0x0d, 0x8d, 0x4d, 0xcd, 0x2d, 0xad, 0x6d, 0xed,
-        0x1d, 0x9d, 0x5d, 0xdd, 0x3d, 0xbd, 0x7d, 0xfd,
-        0x03, 0x83, 0x43, 0xc3, 0x23, 0xa3, 0x63, 0xe3,
-        0x13, 0x93, 0x53, 0xd3, 0x33, 0xb3, 0x73, 0xf3,
-        0x0b, 0x8b, 0x4b, 0xcb, 0x2b, 0xab, 0x6b, 0xeb,
-        0x1b, 0x9b, 0x5b, 0xdb, 0x3b, 0xbb, 0x7b, 0xfb,
-        0x07, 0x87, 0x47, 0xc7, 0x27, 0xa7, 0x67, 0xe7,
-        0x17, 0x97, 0x57, 0xd7, 0x37, 0xb7, 0x77, 0xf7,
-        0x0f, 0x8f, 0x4f, 0xcf, 0x2f, 0xaf, 0x6f, 0xef,
-        0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff,
-    };
+    copy = (GiraffeColumns*)malloc(sizeof(GiraffeColumns));
+    columns_init(copy, c->length > 0 ? c->length : 1);
+    memcpy(copy->array, c->array, c->length * sizeof(GiraffeColumn));
+    copy->length = c->length;
+    copy->header_length = c->header_length;
+    copy->fixed_columns = c->fixed_columns;
+    copy->fixed_length = c->fixed_length;
+    copy->buffer = (unsigned char*)realloc(copy->buffer, copy->header_length * sizeof(unsigned char));
+    for (i=0; i<copy->length; i++) {
+        column = &copy->array[i];
+        column->Database = column->Database ? strdup(column->Database) : NULL;
+        column->Table = column->Table ? strdup(column->Table) : NULL;
+        column->Name = column->Name ? strdup(column->Name) : NULL;
+        column->Alias = column->Alias ? strdup(column->Alias) : NULL;
+        column->Title = column->Title ? strdup(column->Title) : NULL;
+        column->Format = column->Format ? strdup(column->Format) : NULL;
+        column->Default = column->Default ? strdup(column->Default) : NULL;
+        column->Nullable = column->Nullable ? strdup(column->Nullable) : NULL;
+        column->SafeName = column->SafeName ? strdup(column->SafeName) : NULL;
+        Py_XINCREF(column->Key);
+    }
+    return copy;
+}
 
-    for (i=0; i<columns->header_length; i++) {
-        columns->buffer[i] = reverse_lookup[*((*data)++)];
+int column_is_fixed(const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_VARCHAR:
+        case GD_VARBYTE:
+        case GD_NUMBER:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+int columns_is_fixed(const GiraffeColumns *c) {
+    return c->fixed_columns == c->length;
+}
+
+// Advances data past the value of a column without decoding it.
+void column_skip(unsigned char **data, const GiraffeColumn *column) {
+    uint16_t H;
+    switch (column->GDType) {
+        case GD_VARCHAR:
+        case GD_VARBYTE:
+            unpack_uint16_t(data, &H);
+            *data += H;
+            break;
+        case GD_NUMBER:
+            *data += 1 + (*data)[0];
+            break;
+        default:
+            *data += column->Length;
+    }
+}
+
+// Returns a pointer to the value of the column at pos in a row starting
+// with the indicator header. Columns with a constant offset are found
+// directly, the remaining are found by walking the values that precede
+// them, where a null value takes the NullLength of its column.
+unsigned char* columns_locate(const GiraffeColumns *c, unsigned char *row, const size_t pos) {
+    unsigned char *data;
+    size_t i;
+    i = pos < c->fixed_columns ? pos : c->fixed_columns;
+    data = row + c->header_length + c->array[i].Offset;
+    for (; i<pos; i++) {
+        if (indicator_is_null(row, i)) {
+            data += c->array[i].NullLength;
+        } else {
+            column_skip(&data, &c->array[i]);
+        }
+    }
+    return data;
+}
+
+static int popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Copies the indicator header of a row into the columns buffer and returns
+// the number of null columns in the row. The header is counted a 64-bit
+// word at a time so that rows without nulls, the common case, can skip
+// testing each column individually.
+int indicator_set(GiraffeColumns *columns, unsigned char **data) {
+    uint64_t word;
+    size_t i, n = columns->header_length;
+    int nulls = 0;
+    memcpy(columns->buffer, *data, n);
+    for (i=0; i+sizeof(uint64_t)<=n; i+=sizeof(uint64_t)) {
+        memcpy(&word, *data+i, sizeof(uint64_t));
+        nulls += popcount64(word);
+    }
+    for (; i<n; i++) {
+        nulls += popcount64((*data)[i]);
     }
+    *data += n;
+    return nulls;
 }
 
 void indicator_clear(unsigned char **ind, size_t n) {
     memset(*ind, 0, sizeof(unsigned char) * n);
 }
 
-int indicator_read(unsigned char *ind, size_t pos) {
-    return (ind[pos/8] & (1 << (pos % 8)));
+// Reads the null bit of a column from an indicator header, either at the
+// start of a row or as copied by indicator_set, where the most significant
+// bit of the first byte is the first column.
+int indicator_is_null(const unsigned char *row, size_t pos) {
+    return (row[pos/8] & (0x80 >> (pos % 8)));
 }
 
 void indicator_write(unsigned char **ind, size_t pos, int value) {
@@ -67,12 +67,23 @@ typedef struct {
     uint16_t NullLength;
     uint64_t FormatLength;
     char     *SafeName;
+
+    // Byte offset of the column from the end of the indicator header,
+    // constant for every column up to and including the first variable
+    // width column (see GiraffeColumns.fixed_columns).
+    uint64_t Offset;
+
+    // The interned Title, used as the key of rows decoded as dicts so
+    // every row shares the same key objects and their cached hashes.
+    PyObject *Key;
 } GiraffeColumn;
 
 typedef struct {
     size_t           size;
     size_t           length;
     size_t           header_length;
+    size_t           fixed_columns;
+    uint64_t         fixed_length;
     unsigned char    *buffer;
     GiraffeColumn    *array;
     RawStatementInfo *raw;
@@ -129,10 +140,16 @@ GiraffeColumn* column_new();
 void           columns_init(GiraffeColumns *c, size_t initial_size);
 void           columns_append(GiraffeColumns *c, GiraffeColumn element);
 void           columns_free(GiraffeColumns *c);
+GiraffeColumns* columns_copy(const GiraffeColumns *c);
+
+int            column_is_fixed(const GiraffeColumn *column);
+void           column_skip(unsigned char **data, const GiraffeColumn *column);
+int            columns_is_fixed(const GiraffeColumns *c);
+unsigned char* columns_locate(const GiraffeColumns *c, unsigned char *row, const size_t pos);
 
-void indicator_set(GiraffeColumns *columns, unsigned char **data);
+int  indicator_set(GiraffeColumns *columns, unsigned char **data);
 void indicator_clear(unsigned char **ind, size_t n);
-int  indicator_read(unsigned char *ind, size_t pos);
+int  indicator_is_null(const unsigned char *row, size_t pos);
 void indicator_write(unsigned char **ind, size_t pos, int value);
 
 StatementInfoColumn* stmt_info_column_new();
@@ -73,10 +73,14 @@ void debug_printf(const char *fmt, ...);
 PyObject* define_exceptions(PyObject *module);
 
 
+extern PyTypeObject ArrayType;
 extern PyTypeObject CmdType;
 extern PyTypeObject EncoderType;
 extern PyTypeObject ExportType;
+extern PyTypeObject LazyRowType;
 extern PyTypeObject MLoadType;
+extern PyTypeObject RawBlockType;
+extern PyTypeObject RowSchemaType;
 
 extern PyObject *TeradataError;
 extern PyObject *GiraffezError;
@@ -19,6 +19,17 @@
 
 #include "convert.h"
 
+#include <float.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define GIRAFFEZ_SSE2
+#endif
+
+#if defined(__SIZEOF_INT128__)
+  #define GIRAFFEZ_INT128
+#endif
+
 
 void pack_int8_t(unsigned char **data, int8_t val) {
     *((*data)++) = val;
@@ -191,21 +202,625 @@ uint16_t unpack_string(unsigned char **data, char **str) {
     return len;
 }
 
+// Returns 1 when none of the n bytes at s have the high bit set. The bytes
+// are or'd together 16 at a time with SSE2, which every x86-64 processor
+// has, and 8 at a time otherwise.
+static int is_ascii(const unsigned char *s, const size_t n) {
+    const unsigned char *end = s + n;
+    uint64_t word, acc = 0;
+#ifdef GIRAFFEZ_SSE2
+    __m128i acc16 = _mm_setzero_si128();
+    for (; end-s >= 16; s+=16) {
+        acc16 = _mm_or_si128(acc16, _mm_loadu_si128((const __m128i*)s));
+    }
+    if (_mm_movemask_epi8(acc16) != 0) {
+        return 0;
+    }
+#endif
+    for (; end-s >= 8; s+=8) {
+        memcpy(&word, s, sizeof(uint64_t));
+        acc |= word;
+    }
+    for (; s<end; s++) {
+        acc |= *s;
+    }
+    return (acc & 0x8080808080808080ULL) == 0;
+}
+
+// The two digits of each number from 0 to 99, so integers are formatted
+// two digits per division.
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899"
+    "";
+
+static const uint64_t powers_of_10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// Writes the decimal digits of v to buf, at least width of them padded
+// with zeros, and returns the number of bytes written. The output is not
+// null-terminated.
+int format_uint64(char *buf, uint64_t v, const int width) {
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    int n;
+    while (v >= 100) {
+        p -= 2;
+        memcpy(p, digit_pairs + (v % 100) * 2, 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + v * 2, 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+    n = (int)(tmp + sizeof(tmp) - p);
+    if (n < width) {
+        memset(buf, '0', width - n);
+        buf += width - n;
+    }
+    memcpy(buf, p, n);
+    return n < width ? width : n;
+}
+
+int format_int64(char *buf, const int64_t v) {
+    if (v < 0) {
+        *buf = '-';
+        return 1 + format_uint64(buf + 1, 0 - (uint64_t)v, 0);
+    }
+    return format_uint64(buf, (uint64_t)v, 0);
+}
+
+// Writes v scaled down by scale digits, e.g. 12345 with a scale of 2 as
+// 123.45, and returns the number of bytes written.
+int format_scaled_int64(char *buf, const int64_t v, const uint16_t scale) {
+    uint64_t u, p;
+    int n = 0;
+    if (scale == 0) {
+        return format_int64(buf, v);
+    }
+    u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    if (v < 0) {
+        buf[n++] = '-';
+    }
+    if (scale >= 20) {
+        buf[n++] = '0';
+        buf[n++] = '.';
+        return n + format_uint64(buf + n, u, scale);
+    }
+    p = powers_of_10[scale];
+    n += format_uint64(buf + n, u / p, 0);
+    buf[n++] = '.';
+    return n + format_uint64(buf + n, u % p, scale);
+}
+
+// A number f * 2^e with a 64-bit significand, as used by the Grisu
+// algorithm (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", 2010).
+typedef struct {
+    uint64_t f;
+    int      e;
+} diy_fp;
+
+// The powers 10^k for k from -348 to 340 in steps of 8, each rounded to
+// a normalized f * 2^e.
+static const struct {
+    uint64_t f;
+    int16_t  e;
+    int16_t  k;
+} cached_powers_of_10[87] = {
+    {0xfa8fd5a0081c0288ULL, -1220, -348},
+    {0xbaaee17fa23ebf76ULL, -1193, -340},
+    {0x8b16fb203055ac76ULL, -1166, -332},
+    {0xcf42894a5dce35eaULL, -1140, -324},
+    {0x9a6bb0aa55653b2dULL, -1113, -316},
+    {0xe61acf033d1a45dfULL, -1087, -308},
+    {0xab70fe17c79ac6caULL, -1060, -300},
+    {0xff77b1fcbebcdc4fULL, -1034, -292},
+    {0xbe5691ef416bd60cULL, -1007, -284},
+    {0x8dd01fad907ffc3cULL, -980, -276},
+    {0xd3515c2831559a83ULL, -954, -268},
+    {0x9d71ac8fada6c9b5ULL, -927, -260},
+    {0xea9c227723ee8bcbULL, -901, -252},
+    {0xaecc49914078536dULL, -874, -244},
+    {0x823c12795db6ce57ULL, -847, -236},
+    {0xc21094364dfb5637ULL, -821, -228},
+    {0x9096ea6f3848984fULL, -794, -220},
+    {0xd77485cb25823ac7ULL, -768, -212},
+    {0xa086cfcd97bf97f4ULL, -741, -204},
+    {0xef340a98172aace5ULL, -715, -196},
+    {0xb23867fb2a35b28eULL, -688, -188},
+    {0x84c8d4dfd2c63f3bULL, -661, -180},
+    {0xc5dd44271ad3cdbaULL, -635, -172},
+    {0x936b9fcebb25c996ULL, -608, -164},
+    {0xdbac6c247d62a584ULL, -582, -156},
+    {0xa3ab66580d5fdaf6ULL, -555, -148},
+    {0xf3e2f893dec3f126ULL, -529, -140},
+    {0xb5b5ada8aaff80b8ULL, -502, -132},
+    {0x87625f056c7c4a8bULL, -475, -124},
+    {0xc9bcff6034c13053ULL, -449, -116},
+    {0x964e858c91ba2655ULL, -422, -108},
+    {0xdff9772470297ebdULL, -396, -100},
+    {0xa6dfbd9fb8e5b88fULL, -369, -92},
+    {0xf8a95fcf88747d94ULL, -343, -84},
+    {0xb94470938fa89bcfULL, -316, -76},
+    {0x8a08f0f8bf0f156bULL, -289, -68},
+    {0xcdb02555653131b6ULL, -263, -60},
+    {0x993fe2c6d07b7facULL, -236, -52},
+    {0xe45c10c42a2b3b06ULL, -210, -44},
+    {0xaa242499697392d3ULL, -183, -36},
+    {0xfd87b5f28300ca0eULL, -157, -28},
+    {0xbce5086492111aebULL, -130, -20},
+    {0x8cbccc096f5088ccULL, -103, -12},
+    {0xd1b71758e219652cULL, -77, -4},
+    {0x9c40000000000000ULL, -50, 4},
+    {0xe8d4a51000000000ULL, -24, 12},
+    {0xad78ebc5ac620000ULL, 3, 20},
+    {0x813f3978f8940984ULL, 30, 28},
+    {0xc097ce7bc90715b3ULL, 56, 36},
+    {0x8f7e32ce7bea5c70ULL, 83, 44},
+    {0xd5d238a4abe98068ULL, 109, 52},
+    {0x9f4f2726179a2245ULL, 136, 60},
+    {0xed63a231d4c4fb27ULL, 162, 68},
+    {0xb0de65388cc8ada8ULL, 189, 76},
+    {0x83c7088e1aab65dbULL, 216, 84},
+    {0xc45d1df942711d9aULL, 242, 92},
+    {0x924d692ca61be758ULL, 269, 100},
+    {0xda01ee641a708deaULL, 295, 108},
+    {0xa26da3999aef774aULL, 322, 116},
+    {0xf209787bb47d6b85ULL, 348, 124},
+    {0xb454e4a179dd1877ULL, 375, 132},
+    {0x865b86925b9bc5c2ULL, 402, 140},
+    {0xc83553c5c8965d3dULL, 428, 148},
+    {0x952ab45cfa97a0b3ULL, 455, 156},
+    {0xde469fbd99a05fe3ULL, 481, 164},
+    {0xa59bc234db398c25ULL, 508, 172},
+    {0xf6c69a72a3989f5cULL, 534, 180},
+    {0xb7dcbf5354e9beceULL, 561, 188},
+    {0x88fcf317f22241e2ULL, 588, 196},
+    {0xcc20ce9bd35c78a5ULL, 614, 204},
+    {0x98165af37b2153dfULL, 641, 212},
+    {0xe2a0b5dc971f303aULL, 667, 220},
+    {0xa8d9d1535ce3b396ULL, 694, 228},
+    {0xfb9b7cd9a4a7443cULL, 720, 236},
+    {0xbb764c4ca7a44410ULL, 747, 244},
+    {0x8bab8eefb6409c1aULL, 774, 252},
+    {0xd01fef10a657842cULL, 800, 260},
+    {0x9b10a4e5e9913129ULL, 827, 268},
+    {0xe7109bfba19c0c9dULL, 853, 276},
+    {0xac2820d9623bf429ULL, 880, 284},
+    {0x80444b5e7aa7cf85ULL, 907, 292},
+    {0xbf21e44003acdd2dULL, 933, 300},
+    {0x8e679c2f5e44ff8fULL, 960, 308},
+    {0xd433179d9c8cb841ULL, 986, 316},
+    {0x9e19db92b4e31ba9ULL, 1013, 324},
+    {0xeb96bf6ebadf77d9ULL, 1039, 332},
+    {0xaf87023b9bf0ee6bULL, 1066, 340}
+};
+
+// Returns the upper 64 bits of the product of the significands, rounded.
+static diy_fp diy_fp_multiply(const diy_fp x, const diy_fp y) {
+    uint64_t a = x.f >> 32, b = x.f & 0xffffffffULL;
+    uint64_t c = y.f >> 32, d = y.f & 0xffffffffULL;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & 0xffffffffULL) + (bc & 0xffffffffULL) + (1ULL << 31);
+    diy_fp r;
+    r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x) {
+    while ((x.f & 0xffc0000000000000ULL) == 0) {
+        x.f <<= 10;
+        x.e -= 10;
+    }
+    while ((x.f & 0x8000000000000000ULL) == 0) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+// Moves the last digit towards w while that is still inside the safe
+// interval, and returns 0 when the digits cannot be proven to be the
+// closest to w.
+static int grisu_round_weed(char *digits, const int length, const uint64_t distance_too_high_w,
+        const uint64_t unsafe_interval, uint64_t rest, const uint64_t ten_kappa, const uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+            (rest + ten_kappa < small_distance ||
+             small_distance - rest >= rest + ten_kappa - small_distance)) {
+        digits[length-1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+            (rest + ten_kappa < big_distance ||
+             big_distance - rest > rest + ten_kappa - big_distance)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Generates the fewest digits of w, scaled by a cached power of 10, that
+// lie between the scaled boundaries low and high. Returns 0 when the
+// imprecision of the scaling leaves them undecided.
+static int grisu_digit_gen(const diy_fp low, const diy_fp w, const diy_fp high, char *digits,
+        int *length, int *kappa) {
+    uint64_t unit = 1;
+    uint64_t too_low = low.f - unit;
+    uint64_t too_high = high.f + unit;
+    uint64_t unsafe_interval = too_high - too_low;
+    int shift = -w.e;
+    uint64_t one = 1ULL << shift;
+    uint32_t integrals = (uint32_t)(too_high >> shift);
+    uint64_t fractionals = too_high & (one - 1);
+    uint64_t rest;
+    uint32_t divisor;
+    int digit;
+    *kappa = (((64 - shift) + 1) * 1233 >> 12) + 1;
+    if (*kappa > 0 && integrals < powers_of_10[*kappa-1]) {
+        (*kappa)--;
+    }
+    divisor = *kappa > 0 ? (uint32_t)powers_of_10[*kappa-1] : 0;
+    *length = 0;
+    while (*kappa > 0) {
+        digits[(*length)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        (*kappa)--;
+        rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe_interval) {
+            return grisu_round_weed(digits, *length, too_high - w.f, unsafe_interval, rest,
+                (uint64_t)divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        digit = (int)(fractionals >> shift);
+        digits[(*length)++] = (char)('0' + digit);
+        fractionals &= one - 1;
+        (*kappa)--;
+        if (fractionals < unsafe_interval) {
+            return grisu_round_weed(digits, *length, (too_high - w.f) * unit, unsafe_interval,
+                fractionals, one, unit);
+        }
+    }
+}
+
+// Writes the shortest digits that read back as the positive, finite v,
+// choosing those closest to v, so that v is digits * 10^exponent. Returns
+// 0 for the few values, about 0.5%, where this cannot be decided.
+static int grisu3(const double v, char *digits, int *length, int *exponent) {
+    uint64_t bits, significand;
+    int biased, k, index, kappa;
+    diy_fp w, plus, minus, c;
+    memcpy(&bits, &v, sizeof(bits));
+    significand = bits & 0xfffffffffffffULL;
+    biased = (int)((bits >> 52) & 0x7ff);
+    if (biased != 0) {
+        w.f = significand | 0x10000000000000ULL;
+        w.e = biased - 1075;
+    } else {
+        w.f = significand;
+        w.e = -1074;
+    }
+    // The boundaries are halfway to the neighbouring doubles, where the
+    // lower one is closer when the significand is a power of 2
+    plus.f = (w.f << 1) + 1;
+    plus.e = w.e - 1;
+    plus = diy_fp_normalize(plus);
+    if (significand == 0 && biased > 1) {
+        minus.f = (w.f << 2) - 1;
+        minus.e = w.e - 2;
+    } else {
+        minus.f = (w.f << 1) - 1;
+        minus.e = w.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    w = diy_fp_normalize(w);
+    // The cached power brings the binary exponent of the product between
+    // -60 and -32, so its integral part fits in 32 bits
+    k = (int)ceil((-60 - (w.e + 64) + 63) * 0.30102999566398114);
+    index = (348 + k - 1) / 8 + 1;
+    c.f = cached_powers_of_10[index].f;
+    c.e = cached_powers_of_10[index].e;
+    if (!grisu_digit_gen(diy_fp_multiply(minus, c), diy_fp_multiply(w, c),
+            diy_fp_multiply(plus, c), digits, length, &kappa)) {
+        return 0;
+    }
+    *exponent = kappa - cached_powers_of_10[index].k;
+    return 1;
+}
+
+// Parses m * 10^e written without a decimal point, which depends on the
+// locale.
+static double read_scaled_uint64(const uint64_t m, const int e) {
+    char t[32];
+    int n;
+    n = format_uint64(t, m, 0);
+    t[n++] = 'e';
+    if (e < 0) {
+        t[n++] = '-';
+    }
+    n += format_uint64(t + n, (uint64_t)abs(e), 0);
+    t[n] = '\0';
+    return strtod(t, NULL);
+}
+
+// Finds the digits of v the same as grisu3, for the values it leaves
+// undecided. For each number of significant digits, from the fewest that
+// can be needed, the rounding of v is tried and then its neighbours,
+// since next to a power of 2 only one of those may read back as v. Any
+// double reads back from its rounding to 17 digits.
+static void shortest_digits(const double v, char *digits, int *length, int *exponent) {
+    char s[32];
+    uint64_t m, candidates[3];
+    int i, j, p, e;
+    for (p = v < DBL_MIN ? 1 : DBL_DIG; p<=17; p++) {
+        snprintf(s, sizeof(s), "%.*e", p - 1, v);
+        m = 0;
+        for (i=0; s[i] != 'e'; i++) {
+            if (s[i] >= '0' && s[i] <= '9') {
+                m = m * 10 + (s[i] - '0');
+            }
+        }
+        e = atoi(s + i + 1) - (p - 1);
+        candidates[0] = m;
+        candidates[1] = m + 1;
+        candidates[2] = m - 1;
+        for (j=0; j<3; j++) {
+            if (p == 17 || read_scaled_uint64(candidates[j], e) == v) {
+                m = candidates[j];
+                while (m % 10 == 0) {
+                    m /= 10;
+                    e++;
+                }
+                *length = format_uint64(digits, m, 0);
+                *exponent = e;
+                return;
+            }
+        }
+    }
+}
+
+// Writes the shortest text that reads back as exactly d, the same as
+// repr(d), and returns the number of bytes written. Integral values are
+// written with a trailing .0 when add_dot_0 is set. At most 24 bytes are
+// written. No memory is allocated and the GIL is not needed.
+int format_double(char *buf, const double d, const int add_dot_0) {
+    char digits[20];
+    int length, exponent, point, n = 0, i;
+    uint64_t bits;
+    double v = d;
+    if (Py_IS_NAN(d)) {
+        memcpy(buf, "nan", 3);
+        return 3;
+    }
+    memcpy(&bits, &d, sizeof(bits));
+    if (bits >> 63) {
+        buf[n++] = '-';
+        v = -d;
+    }
+    if (Py_IS_INFINITY(v)) {
+        memcpy(buf + n, "inf", 3);
+        return n + 3;
+    }
+    if (v == 0) {
+        digits[0] = '0';
+        length = 1;
+        exponent = 0;
+    } else if (!grisu3(v, digits, &length, &exponent)) {
+        shortest_digits(v, digits, &length, &exponent);
+    }
+    // The position of the decimal point relative to the first digit, with
+    // the same switch to an exponent as repr
+    point = length + exponent;
+    if (point > 16 || point <= -4) {
+        buf[n++] = digits[0];
+        if (length > 1) {
+            buf[n++] = '.';
+            memcpy(buf + n, digits + 1, length - 1);
+            n += length - 1;
+        }
+        buf[n++] = 'e';
+        buf[n++] = point - 1 < 0 ? '-' : '+';
+        return n + format_uint64(buf + n, (uint64_t)abs(point - 1), 2);
+    }
+    if (point <= 0) {
+        buf[n++] = '0';
+        buf[n++] = '.';
+        for (i=point; i<0; i++) {
+            buf[n++] = '0';
+        }
+        memcpy(buf + n, digits, length);
+        return n + length;
+    }
+    if (point < length) {
+        memcpy(buf + n, digits, point);
+        n += point;
+        buf[n++] = '.';
+        memcpy(buf + n, digits + point, length - point);
+        return n + length - point;
+    }
+    memcpy(buf + n, digits, length);
+    n += length;
+    for (i=length; i<point; i++) {
+        buf[n++] = '0';
+    }
+    if (add_dot_0) {
+        buf[n++] = '.';
+        buf[n++] = '0';
+    }
+    return n;
+}
+
+// Returns the offset of the first of the n bytes at s equal to any of the
+// four given bytes, or n when there is none. Bytes are compared 16 at a
+// time with SSE2 and one at a time otherwise.
+size_t find_any_of4(const char *s, const size_t n, const char a, const char b, const char c,
+        const char d) {
+    size_t i = 0;
+#ifdef GIRAFFEZ_SSE2
+    __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+    __m128i v;
+    int mask;
+    for (; n-i >= 16; i+=16) {
+        v = _mm_loadu_si128((const __m128i*)(s + i));
+        mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd))));
+        if (mask != 0) {
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                i++;
+            }
+            return i;
+        }
+    }
+#endif
+    for (; i<n; i++) {
+        if (s[i] == a || s[i] == b || s[i] == c || s[i] == d) {
+            return i;
+        }
+    }
+    return n;
+}
+
+// Returns the offset of the first of the n bytes at s that must be escaped
+// in a JSON string, a double quote, a backslash or a control character, or
+// n when there is none.
+static size_t json_find_escape(const unsigned char *s, const size_t n) {
+    size_t i = 0;
+#ifdef GIRAFFEZ_SSE2
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    __m128i v;
+    int mask;
+    for (; n-i >= 16; i+=16) {
+        v = _mm_loadu_si128((const __m128i*)(s + i));
+        mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(v, control), control)));
+        if (mask != 0) {
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                i++;
+            }
+            return i;
+        }
+    }
+#endif
+    for (; i<n; i++) {
+        if (s[i] == '"' || s[i] == '\\' || s[i] < 0x20) {
+            return i;
+        }
+    }
+    return n;
+}
+
+// Writes the n bytes at s to dst escaped as the contents of a JSON string,
+// the same as json.dumps with ensure_ascii=False, and returns the number of
+// bytes written. dst must have room for 6 bytes for each byte of s. Runs of
+// bytes that need no escaping are copied as they are.
+size_t json_escape(char *dst, const char *s, const size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *u = (const unsigned char*)s;
+    char *start = dst;
+    size_t i = 0, k;
+    while (i < n) {
+        k = json_find_escape(u + i, n - i);
+        memcpy(dst, s + i, k);
+        dst += k;
+        if ((i += k) >= n) {
+            break;
+        }
+        *dst++ = '\\';
+        switch (u[i]) {
+            case '"':  *dst++ = '"';  break;
+            case '\\': *dst++ = '\\'; break;
+            case '\n': *dst++ = 'n';  break;
+            case '\r': *dst++ = 'r';  break;
+            case '\t': *dst++ = 't';  break;
+            case '\b': *dst++ = 'b';  break;
+            case '\f': *dst++ = 'f';  break;
+            default:
+                *dst++ = 'u';
+                *dst++ = '0';
+                *dst++ = '0';
+                *dst++ = hex[u[i] >> 4];
+                *dst++ = hex[u[i] & 0xf];
+        }
+        i++;
+    }
+    return dst - start;
+}
+
+// Text is almost always ASCII, in which case the string is created with
+// the width already known and the bytes copied in, rather than run through
+// the general UTF-8 decoder.
+PyObject* utf8_to_pystring(const char *buf, const size_t length) {
+#if PY_MAJOR_VERSION >= 3
+    PyObject *str;
+    if (is_ascii((const unsigned char*)buf, length)) {
+        Py_RETURN_ERROR(str = PyUnicode_New(length, 127));
+        memcpy(PyUnicode_1BYTE_DATA(str), buf, length);
+        return str;
+    }
+#endif
+    return PyUnicode_FromStringAndSize(buf, length);
+}
+
 // Character types
 PyObject* teradata_char_to_pystring(unsigned char **data, const uint64_t column_length) {
-    PyObject *str = PyUnicode_FromStringAndSize((char*)*data, column_length);
+    PyObject *str = utf8_to_pystring((char*)*data, column_length);
     *data += column_length;
     return str;
 }
 
-PyObject* teradata_char_to_pystring_f(unsigned char **data, const uint64_t column_length, const uint64_t format_length) {
-    PyObject *str = teradata_char_to_pystring(data, column_length);
-    if (format_length > 0 && format_length <= column_length) {
-        PyObject *slice = PySlice_New(PyLong_FromLong(0),
-                PyLong_FromUnsignedLongLong(format_length), PyLong_FromLong(1));
-        Py_SETREF(str, PyObject_GetItem(str, slice));
-        Py_DECREF(slice);
+// Returns the number of bytes of a CHAR value to convert: the first
+// format_length characters when the column has a FORMAT of X(n), less any
+// trailing padding when trim is set. The FORMAT counts characters, so the
+// value is cut at the start of a UTF-8 sequence.
+uint64_t teradata_char_length(const unsigned char *s, const uint64_t column_length,
+        const uint64_t format_length, const int trim) {
+    uint64_t n = column_length;
+    uint64_t chars = 0;
+    if (format_length > 0 && format_length < column_length) {
+        for (n=0; n<column_length; n++) {
+            if ((s[n] & 0xc0) != 0x80 && chars++ == format_length) {
+                break;
+            }
+        }
     }
+    if (trim) {
+        while (n > 0 && s[n-1] == ' ') {
+            n--;
+        }
+    }
+    return n;
+}
+
+PyObject* teradata_char_to_pystring_f(unsigned char **data, const uint64_t column_length, const uint64_t format_length) {
+    PyObject *str;
+    str = utf8_to_pystring((char*)*data, teradata_char_length(*data, column_length, format_length, 0));
+    *data += column_length;
+    return str;
+}
+
+PyObject* teradata_char_to_pystring_trimmed(unsigned char **data, const uint64_t column_length,
+        const uint64_t format_length) {
+    PyObject *str;
+    str = utf8_to_pystring((char*)*data, teradata_char_length(*data, column_length, format_length, 1));
+    *data += column_length;
     return str;
 }
 
@@ -219,7 +834,7 @@ PyObject* teradata_varchar_to_pystring(unsigned char **data) {
     PyObject *str;
     uint16_t H;
     unpack_uint16_t(data, &H);
-    str = PyUnicode_FromStringAndSize((char*)*data, H);
+    str = utf8_to_pystring((char*)*data, H);
     *data += H;
     return str;
 }
@@ -234,6 +849,11 @@ PyObject* teradata_varbyte_to_pybytes(unsigned char **data) {
 }
 
 // Numeric types
+static PyObject* pystring_from_int64(const int64_t v) {
+    char buf[24];
+    return PyUnicode_FromStringAndSize(buf, format_int64(buf, v));
+}
+
 PyObject* teradata_byteint_to_pylong(unsigned char **data) {
     int8_t b;
     unpack_int8_t(data, &b);
@@ -243,7 +863,7 @@ PyObject* teradata_byteint_to_pylong(unsigned char **data) {
 PyObject* teradata_byteint_to_pystring(unsigned char **data) {
     int8_t b;
     unpack_int8_t(data, &b);
-    return PyUnicode_FromFormat("%d", b);
+    return pystring_from_int64(b);
 }
 
 PyObject* teradata_smallint_to_pylong(unsigned char **data) {
@@ -255,7 +875,7 @@ PyObject* teradata_smallint_to_pylong(unsigned char **data) {
 PyObject* teradata_smallint_to_pystring(unsigned char **data) {
     int16_t h;
     unpack_int16_t(data, &h);
-    return PyUnicode_FromFormat("%d", h);
+    return pystring_from_int64(h);
 }
 
 PyObject* teradata_int_to_pylong(unsigned char **data) {
@@ -267,7 +887,7 @@ PyObject* teradata_int_to_pylong(unsigned char **data) {
 PyObject* teradata_int_to_pystring(unsigned char **data) {
     int32_t l;
     unpack_int32_t(data, &l);
-    return PyUnicode_FromFormat("%d", l);
+    return pystring_from_int64(l);
 }
 
 PyObject* teradata_bigint_to_pylong(unsigned char **data) {
@@ -279,7 +899,7 @@ PyObject* teradata_bigint_to_pylong(unsigned char **data) {
 PyObject* teradata_bigint_to_pystring(unsigned char **data) {
     int64_t q;
     unpack_int64_t(data, &q);
-    return pystring_from_cformat("%lld", q);
+    return pystring_from_int64(q);
 }
 
 PyObject* teradata_float_to_pyfloat(unsigned char **data) {
@@ -377,218 +997,386 @@ int teradata_decimal_to_cstring(unsigned char **data, const uint64_t column_leng
     return -1;
 }
 
+static int terminate(char *buf, const int n) {
+    buf[n] = '\0';
+    return n;
+}
+
 int teradata_decimal8_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf) {
-    int8_t b, x, y, scale;
+    int8_t b;
     unpack_int8_t(data, &b);
-    if (column_scale > 0) {
-        const char *fmt = b < 0 ? "-%d.%0*d" : "%d.%0*d";
-        scale = (int8_t)pow(10, column_scale);
-        x = abs(b / scale);
-        y = abs(b % scale);
-        return sprintf(buf, fmt, x, column_scale, y);
-    } else {
-        return sprintf(buf, "%d", b);
-    }
-    return -1;
+    return terminate(buf, format_scaled_int64(buf, b, column_scale));
 }
 
 int teradata_decimal16_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf) {
-    int16_t h, x, y, scale;
+    int16_t h;
     unpack_int16_t(data, &h);
-    if (column_scale > 0) {
-        const char *fmt = h < 0 ? "-%d.%0*d" : "%d.%0*d";
-        scale = (int16_t)pow(10, column_scale);
-        x = abs(h / scale);
-        y = abs(h % scale);
-        return sprintf(buf, fmt, x, column_scale, y);
-    } else {
-        return sprintf(buf, "%d", h);
-    }
-    return -1;
+    return terminate(buf, format_scaled_int64(buf, h, column_scale));
 }
 
 int teradata_decimal32_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf) {
-    int32_t l, x, y, scale;
+    int32_t l;
     unpack_int32_t(data, &l);
-    if (column_scale > 0) {
-        const char *fmt = l < 0 ? "-%d.%0*d" : "%d.%0*d";
-        scale = (int32_t)pow(10, column_scale);
-        x = labs(l / scale);
-        y = labs(l % scale);
-        return sprintf(buf, fmt, x, column_scale, y);
-    } else {
-        return sprintf(buf, "%d", l);
-    }
-    return -1;
+    return terminate(buf, format_scaled_int64(buf, l, column_scale));
 }
 
 int teradata_decimal64_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf) {
-    int64_t q, x, y, scale;
+    int64_t q;
     unpack_int64_t(data, &q);
-    if (column_scale > 0) {
-#ifdef _MSC_VER
-        const char *fmt = q < 0 ? "-%I64d.%0*I64d" : "%I64d.%0*I64d";
-#else
-        const char *fmt = q < 0 ? "-%lld.%0*lld" : "%lld.%0*lld";
-#endif
-        scale = (int64_t)pow(10, column_scale);
-        x = llabs(q / scale);
-        y = llabs(q % scale);
-        return sprintf(buf, fmt, x, column_scale, y);
-    } else {
-#ifdef _MSC_VER
-        return sprintf(buf, "%I64d", q);
-#elif defined(__APPLE__)
-        return sprintf(buf, "%lld", q);
-#else
-        return sprintf(buf, "%ld", q);
-#endif
+    return terminate(buf, format_scaled_int64(buf, q, column_scale));
+}
+
+// The powers of 10 that are exactly representable as doubles.
+static const double exact_powers_of_10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_DOUBLE_INT (1LL << 53)
+
+// Converts v * 10^-scale to the nearest double. When v and the power of
+// 10 are both exact doubles, a single division or multiplication is
+// correctly rounded, giving the same result as parsing the decimal text.
+// Returns -1 when the value is outside of that range.
+static int scaled_int64_to_double(const int64_t v, const int scale, double *d) {
+    if (v > MAX_EXACT_DOUBLE_INT || v < -MAX_EXACT_DOUBLE_INT) {
+        return -1;
+    }
+    if (scale >= 0 && scale <= 22) {
+        *d = (double)v / exact_powers_of_10[scale];
+        return 0;
+    }
+    if (scale < 0 && scale >= -22) {
+        *d = (double)v * exact_powers_of_10[-scale];
+        return 0;
     }
     return -1;
 }
 
-int teradata_number_to_cstring(unsigned char **data, char *str) {
-    int i = 0, j = 0;
-    uint64_t d, r;
-    char buf[38];
-    int sign;
-    TeradataNumber n = {
-        .length = 0,
-        .scale = 0,
-        .v1 = 0,
-        .v2 = 0,
-        .v3 = 0,
-        .v4 = 0,
-    };
-    memcpy(&n.length, *data, sizeof(n.length));
-    *data += sizeof(n.length);
-    if (n.length == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return 1;
-    }
-    memcpy(&n.scale, *data, sizeof(n.scale));
-    *data += sizeof(n.scale);
-    memcpy(n.data, *data, n.length-sizeof(n.scale));
-    *data += n.length-sizeof(n.scale);
-    sign = (n.data[n.length-3] >> 7) & 1;
-    if (sign) {
-        for (long unsigned int i = n.length - 2; i < sizeof(n.data); i++) {
-            n.data[i] = 0xff;
-        }
-        n.v1 = ~n.v1 + 1;
-        n.v2 = ~n.v2;
-        n.v3 = ~n.v3;
-        n.v4 = ~n.v4;
-        if (n.v1 == 0) {
-            n.v2 += 1;
-            if (n.v2 == 0) {
-                n.v3 += 1;
-                if (n.v3 == 0) {
-                    n.v4 += 1;
-                }
+// Converts a DECIMAL value to the nearest double directly from its scaled
+// integer. Returns -1, leaving data unchanged, when the unscaled value is
+// larger than 2^53 in magnitude, in which case the value must be formatted
+// and parsed instead.
+int teradata_decimal_to_double(unsigned char **data, const uint64_t column_length,
+        const uint16_t column_scale, double *d) {
+    unsigned char *p = *data;
+    int8_t b; int16_t h; int32_t l; int64_t q; uint64_t Q;
+    switch (column_length) {
+        case DECIMAL8:
+            unpack_int8_t(&p, &b);
+            q = b;
+            break;
+        case DECIMAL16:
+            unpack_int16_t(&p, &h);
+            q = h;
+            break;
+        case DECIMAL32:
+            unpack_int32_t(&p, &l);
+            q = l;
+            break;
+        case DECIMAL64:
+            unpack_int64_t(&p, &q);
+            break;
+        case DECIMAL128:
+            unpack_uint64_t(&p, &Q);
+            unpack_int64_t(&p, &q);
+            // only values where the high half is the sign of the low half
+            if ((q != 0 || Q > (uint64_t)MAX_EXACT_DOUBLE_INT) &&
+                    (q != -1 || Q < (uint64_t)-MAX_EXACT_DOUBLE_INT)) {
+                return -1;
             }
-        }
+            q = (int64_t)Q;
+            break;
+        default:
+            return -1;
     }
-    do {
-        r = n.v4;
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n.v3;
-        n.v4 = d;
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n.v2;
-        n.v3 = d;
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n.v1;
-        n.v2 = d;
-        d = r / 10;
-        r = r - d * 10;
-        n.v1 = d;
-        buf[i++] = r + '0';
-    } while (i <= n.scale || n.v1 || n.v2 || n.v3 || n.v4);
-    if (sign) {
-        str[j++] = '-';
-    }
-
-    // leading zeros
-    if (n.scale > 0 && n.scale > i) {
-        for (int k=0;k<abs(n.scale);k++) {
-            str[j++] = '0';
-        }
+    if (scaled_int64_to_double(q, column_scale, d) != 0) {
+        return -1;
+    }
+    *data = p;
+    return 0;
+}
+
+// Converts a NUMBER value to the nearest double directly from its
+// variable length unscaled integer, the same as
+// teradata_decimal_to_double.
+int teradata_number_to_double(unsigned char **data, double *d) {
+    unsigned char *p = *data;
+    int8_t length;
+    int16_t scale;
+    uint64_t v = 0;
+    int i, n;
+    unpack_int8_t(&p, &length);
+    if (length == 0) {
+        *d = 0.0;
+        *data = p;
+        return 0;
+    }
+    n = length - (int)sizeof(scale);
+    if (n <= 0 || n > (int)sizeof(v)) {
+        return -1;
+    }
+    unpack_int16_t(&p, &scale);
+    // the unscaled value is a little-endian two's complement integer
+    for (i=n; i-->0;) {
+        v = (v << 8) | p[i];
     }
-    while (i != 0) {
-        str[j++] = buf[--i];
+    if (n < (int)sizeof(v) && (p[n-1] & 0x80)) {
+        v |= ~0ULL << (n * 8);
+    }
+    if (scaled_int64_to_double((int64_t)v, scale, d) != 0) {
+        return -1;
     }
+    *data = p + n;
+    return 0;
+}
 
-    // trailing zeros
-    if (n.scale < 0) {
-        for (int i=0;i<abs(n.scale);i++) {
-            str[j++] = '0';
+// Writes the decimal digits of the 128-bit unsigned integer hi:lo to buf
+// and returns the number of digits. The integer is split into chunks of 19
+// digits with native 128-bit division where the compiler supports it, and
+// into chunks of 9 digits by long division over 32-bit limbs otherwise.
+static int format_uint128(char *buf, uint64_t hi, uint64_t lo) {
+    uint64_t chunks[5];
+    int k = 0, n, width;
+#ifdef GIRAFFEZ_INT128
+    const uint64_t base = 10000000000000000000ULL;
+    unsigned __int128 u = ((unsigned __int128)hi << 64) | lo;
+    unsigned __int128 q;
+    width = 19;
+    while (u >= base) {
+        q = u / base;
+        chunks[k++] = (uint64_t)(u - q * base);
+        u = q;
+    }
+    n = format_uint64(buf, (uint64_t)u, 0);
+#else
+    const uint32_t base = 1000000000;
+    uint32_t limbs[4];
+    uint64_t r;
+    int i;
+    limbs[0] = (uint32_t)(hi >> 32);
+    limbs[1] = (uint32_t)hi;
+    limbs[2] = (uint32_t)(lo >> 32);
+    limbs[3] = (uint32_t)lo;
+    width = 9;
+    while (limbs[0] || limbs[1] || limbs[2] || limbs[3] >= base) {
+        r = 0;
+        for (i=0; i<4; i++) {
+            r = (r << 32) | limbs[i];
+            limbs[i] = (uint32_t)(r / base);
+            r %= base;
         }
+        chunks[k++] = r;
+    }
+    n = format_uint64(buf, limbs[3], 0);
+#endif
+    while (k > 0) {
+        n += format_uint64(buf + n, chunks[--k], width);
     }
-    str[j] = '\0';
+    return n;
+}
 
-    if (n.scale <= 0) {
-        return j;
+// Writes the 128-bit two's complement integer hi:lo scaled down by scale
+// digits, or up when the scale is negative, as a null-terminated string
+// and returns its length.
+static int format_scaled_int128(char *buf, uint64_t hi, uint64_t lo, const int scale) {
+    char digits[40];
+    int n, j = 0;
+    if ((int64_t)hi < 0) {
+        buf[j++] = '-';
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0);
+    }
+    n = format_uint128(digits, hi, lo);
+    if (scale <= 0) {
+        memcpy(buf + j, digits, n);
+        j += n;
+        memset(buf + j, '0', -scale);
+        j -= scale;
+    } else if (n > scale) {
+        memcpy(buf + j, digits, n - scale);
+        j += n - scale;
+        buf[j++] = '.';
+        memcpy(buf + j, digits + n - scale, scale);
+        j += scale;
+    } else {
+        buf[j++] = '0';
+        buf[j++] = '.';
+        memset(buf + j, '0', scale - n);
+        j += scale - n;
+        memcpy(buf + j, digits, n);
+        j += n;
     }
-    // insert decimal point
-    memmove(str + (j - n.scale) + 1, str + (j - n.scale), j);
-    str[(j++ - n.scale)] = '.';
+    buf[j] = '\0';
     return j;
 }
 
+// Reads the unscaled value of a NUMBER, a little-endian two's complement
+// integer of up to 16 bytes, into hi:lo along with its scale. Returns -1
+// when the length of the value is invalid.
+static int number_unpack(unsigned char **data, int16_t *scale, uint64_t *hi, uint64_t *lo) {
+    int8_t length;
+    int i, n;
+    *scale = 0;
+    *hi = *lo = 0;
+    unpack_int8_t(data, &length);
+    if (length == 0) {
+        return 0;
+    }
+    n = length - (int)sizeof(*scale);
+    if (n <= 0 || n > 16) {
+        return -1;
+    }
+    unpack_int16_t(data, scale);
+    for (i=n; i-->0;) {
+        *hi = (*hi << 8) | (*lo >> 56);
+        *lo = (*lo << 8) | (*data)[i];
+    }
+    if ((*data)[n-1] & 0x80) {
+        if (n < 8) {
+            *lo |= ~0ULL << (n * 8);
+            *hi = ~0ULL;
+        } else if (n < 16) {
+            *hi |= ~0ULL << ((n - 8) * 8);
+        }
+    }
+    *data += n;
+    return 0;
+}
 
+int teradata_number_to_cstring(unsigned char **data, char *str) {
+    int16_t scale;
+    uint64_t hi, lo;
+    if ((*data)[0] == 0) {
+        *data += 1;
+        str[0] = '0';
+        str[1] = '\0';
+        return 1;
+    }
+    if (number_unpack(data, &scale, &hi, &lo) != 0) {
+        return -1;
+    }
+    return format_scaled_int128(str, hi, lo, scale);
+}
 
 int teradata_decimal128_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf) {
-    char s[38];
-    int i = 0, j = 0;
-    uint64_t complement, sign, r, d, Q;
+    uint64_t Q;
     int64_t q;
-    uint64_t n[4];
     unpack_uint64_t(data, &Q);
     unpack_int64_t(data, &q);
-    sign = (q >> 63);
-    complement = q;
-    if (sign) {
-        complement = ~complement;
-        Q = ~Q + 1;
-        if (Q == 0) {
-            complement += 1;
-        }
+    return format_scaled_int128(buf, (uint64_t)q, Q, column_scale);
+}
+
+int format_int128(char *buf, const uint64_t hi, const uint64_t lo) {
+    return format_scaled_int128(buf, hi, lo, 0);
+}
+
+// Multiplies the unsigned 128-bit integer hi:lo by 10. Returns -1 when
+// the product no longer fits in a signed 128-bit integer.
+static int uint128_mul10(uint64_t *hi, uint64_t *lo) {
+    uint64_t a = (*lo & 0xffffffffULL) * 10;
+    uint64_t b = (*lo >> 32) * 10 + (a >> 32);
+    if (*hi > (0x7fffffffffffffffULL - (b >> 32)) / 10) {
+        return -1;
     }
-    n[0] = complement >> 32;
-    n[1] = complement & 0xffffffff;
-    n[2] = (Q >> 32) & 0xffffffff;
-    n[3] = Q & 0xffffffff;
-    memset(s, 0, sizeof(s));
-    do {
-        r = n[0];
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n[1];
-        n[0] = d;
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n[2];
-        n[1] = d;
-        d = r / 10;
-        r = ((r - d * 10) << 32) + n[3];
-        n[2] = d;
-        d = r / 10;
-        r = r - d * 10;
-        n[3] = d;
-        s[i] = r + '0';
-        i++;
-    } while (i <= column_scale || n[0] || n[1] || n[2] || n[3]);
-    if (sign) {
-        buf[j++] = '-';
+    *hi = *hi * 10 + (b >> 32);
+    *lo = (b << 32) | (a & 0xffffffffULL);
+    return 0;
+}
+
+// Divides the unsigned 128-bit integer hi:lo by 10 and returns the
+// remainder.
+static int uint128_div10(uint64_t *hi, uint64_t *lo) {
+    uint64_t r, q1, x;
+    r = *hi % 10;
+    *hi /= 10;
+    x = (r << 32) | (*lo >> 32);
+    q1 = x / 10;
+    x = ((x % 10) << 32) | (*lo & 0xffffffffULL);
+    *lo = (q1 << 32) | (x / 10);
+    return (int)(x % 10);
+}
+
+// Reads the unscaled value of a DECIMAL of any width into the 128-bit two's
+// complement integer hi:lo. The value is worth hi:lo * 10^-column_scale.
+int teradata_decimal_to_int128(unsigned char **data, const uint64_t column_length, uint64_t *hi,
+        uint64_t *lo) {
+    int8_t b; int16_t h; int32_t l; int64_t q;
+    switch (column_length) {
+        case DECIMAL8:
+            unpack_int8_t(data, &b);
+            q = b;
+            break;
+        case DECIMAL16:
+            unpack_int16_t(data, &h);
+            q = h;
+            break;
+        case DECIMAL32:
+            unpack_int32_t(data, &l);
+            q = l;
+            break;
+        case DECIMAL64:
+            unpack_int64_t(data, &q);
+            break;
+        case DECIMAL128:
+            unpack_uint64_t(data, lo);
+            unpack_int64_t(data, &q);
+            *hi = (uint64_t)q;
+            return 0;
+        default:
+            return -1;
+    }
+    *lo = (uint64_t)q;
+    *hi = q < 0 ? ~0ULL : 0;
+    return 0;
+}
+
+// Reads the unscaled value of a NUMBER into the 128-bit two's complement
+// integer hi:lo, rescaled from the scale of the value to column_scale so
+// that every value of the column shares the same scale, as with DECIMAL.
+// Returns -1, leaving data unchanged, when the value has more fractional
+// digits than column_scale or does not fit in 128 bits once rescaled.
+int teradata_number_to_int128(unsigned char **data, const int column_scale, uint64_t *hi,
+        uint64_t *lo) {
+    unsigned char *p = *data;
+    int16_t scale;
+    int negative;
+    if (number_unpack(&p, &scale, hi, lo) != 0) {
+        return -1;
     }
-    while (i != 0) {
-        if (i == column_scale) {
-            buf[j++] = '.';
+    if ((negative = (int64_t)*hi < 0)) {
+        *lo = ~*lo + 1;
+        *hi = ~*hi + (*lo == 0);
+    }
+    for (; scale < column_scale; scale++) {
+        if (uint128_mul10(hi, lo) != 0) {
+            return -1;
         }
-        buf[j++] = s[--i];
     }
-    buf[j] = '\0';
-    return j;
+    for (; scale > column_scale; scale--) {
+        if (uint128_div10(hi, lo) != 0) {
+            return -1;
+        }
+    }
+    if (negative) {
+        *lo = ~*lo + 1;
+        *hi = ~*hi + (*lo == 0);
+    }
+    *data = p;
+    return 0;
+}
+
+PyObject* pylong_from_int128(const uint64_t hi, const uint64_t lo) {
+    unsigned char bytes[16];
+    int i;
+    if (hi == ((int64_t)lo < 0 ? ~0ULL : 0)) {
+        return PyLong_FromLongLong((int64_t)lo);
+    }
+    for (i=0; i<8; i++) {
+        bytes[i] = (unsigned char)(lo >> (i * 8));
+        bytes[i+8] = (unsigned char)(hi >> (i * 8));
+    }
+    return _PyLong_FromByteArray(bytes, sizeof(bytes), 1, 1);
 }
 
 PyObject* cstring_to_pyfloat(const char *buf, const int length) {
@@ -604,12 +1392,19 @@ PyObject* cstring_to_pyfloat(const char *buf, const int length) {
     return obj;
 }
 
+PyObject* cstring_to_pylong(const char *buf, const int length) {
+    char s[BUFFER_ITEM_SIZE];
+    memcpy(s, buf, length);
+    s[length] = '\0';
+    return PyLong_FromString(s, NULL, 10);
+}
+
 PyObject* cstring_to_giraffez_decimal(const char *buf, const int length) {
     return giraffez_decimal_from_pystring(cstring_to_pystring(buf, length));
 }
 
 PyObject* cstring_to_pystring(const char *buf, const int length) {
-    return PyUnicode_FromStringAndSize(buf, length);
+    return utf8_to_pystring(buf, length);
 }
 
 PyObject* pystring_from_cformat(const char *fmt, ...) {
@@ -70,6 +70,10 @@ uint16_t unpack_string(unsigned char **data, char **str);
 // Character types
 PyObject* teradata_char_to_pystring(unsigned char **data, const uint64_t column_length);
 PyObject* teradata_char_to_pystring_f(unsigned char **data, const uint64_t column_length, const uint64_t format_length);
+PyObject* teradata_char_to_pystring_trimmed(unsigned char **data, const uint64_t column_length,
+    const uint64_t format_length);
+uint64_t teradata_char_length(const unsigned char *s, const uint64_t column_length,
+    const uint64_t format_length, const int trim);
 PyObject* teradata_byte_to_pybytes(unsigned char **data, const uint64_t column_length);
 PyObject* teradata_varchar_to_pystring(unsigned char **data);
 PyObject* teradata_varbyte_to_pybytes(unsigned char **data);
@@ -101,31 +105,33 @@ int teradata_decimal16_to_cstring(unsigned char **data, const uint16_t column_sc
 int teradata_decimal32_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf);
 int teradata_decimal64_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf);
 
-
-typedef struct TeradataNumber {
-    int8_t length;
-    int16_t scale;
-
-    union {
-        struct {
-            uint32_t v1;
-            uint32_t v2;
-            uint32_t v3;
-            uint32_t v4;
-        };
-        unsigned char data[4*sizeof(uint32_t)];
-    };
-} TeradataNumber;
-
 int teradata_number_to_cstring(unsigned char **data, char *str);
+int teradata_decimal_to_double(unsigned char **data, const uint64_t column_length,
+    const uint16_t column_scale, double *d);
+int teradata_number_to_double(unsigned char **data, double *d);
 
 int teradata_decimal128_to_cstring(unsigned char **data, const uint16_t column_scale, char *buf);
+int teradata_decimal_to_int128(unsigned char **data, const uint64_t column_length, uint64_t *hi,
+    uint64_t *lo);
+int teradata_number_to_int128(unsigned char **data, const int column_scale, uint64_t *hi,
+    uint64_t *lo);
+PyObject* pylong_from_int128(const uint64_t hi, const uint64_t lo);
 PyObject* teradata_number_from_pystring(PyObject *item, unsigned char **buf, uint16_t *packed_length);
 
 
+PyObject* utf8_to_pystring(const char *buf, const size_t length);
+size_t    find_any_of4(const char *s, const size_t n, const char a, const char b, const char c,
+    const char d);
+size_t    json_escape(char *dst, const char *s, const size_t n);
+int       format_uint64(char *buf, uint64_t v, const int width);
+int       format_int64(char *buf, const int64_t v);
+int       format_scaled_int64(char *buf, const int64_t v, const uint16_t scale);
+int       format_int128(char *buf, const uint64_t hi, const uint64_t lo);
+int       format_double(char *buf, const double d, const int add_dot_0);
 PyObject* cstring_to_pystring(const char *buf, const int length);
 PyObject* cstring_to_giraffez_decimal(const char *buf, const int length);
 PyObject* cstring_to_pyfloat(const char *buf, const int length);
+PyObject* cstring_to_pylong(const char *buf, const int length);
 PyObject* pystring_from_cformat(const char* fmt, ...);
 PyObject* pystring_to_pylong(PyObject *s);
 PyObject* pystring_to_pyfloat(PyObject *s);
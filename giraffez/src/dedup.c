@@ -0,0 +1,100 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "dedup.h"
+
+
+#define VALUE_CACHE_SIZE (VALUE_CACHE_MAX_ENTRIES * 2)
+
+// FNV-1a, which is plenty for the short keys stored here.
+static uint64_t value_cache_hash(const unsigned char *key, const size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    size_t i;
+    for (i=0; i<n; i++) {
+        h ^= key[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+ValueCache* value_cache_new() {
+    ValueCache *c;
+    if ((c = (ValueCache*)malloc(sizeof(ValueCache))) == NULL) {
+        return NULL;
+    }
+    c->length = 0;
+    if ((c->entries = (ValueCacheEntry*)calloc(VALUE_CACHE_SIZE, sizeof(ValueCacheEntry))) == NULL) {
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+// Returns a borrowed reference to the object cached for the key, or NULL
+// without an exception set. The hash of the key is stored in hash so it
+// can be reused by value_cache_put.
+PyObject* value_cache_get(const ValueCache *c, const unsigned char *key, const size_t n,
+        uint64_t *hash) {
+    ValueCacheEntry *entry;
+    size_t i;
+    *hash = value_cache_hash(key, n);
+    for (i=*hash & (VALUE_CACHE_SIZE-1); c->entries[i].value != NULL; i=(i+1) & (VALUE_CACHE_SIZE-1)) {
+        entry = &c->entries[i];
+        if (entry->hash == *hash && entry->length == n && memcmp(entry->key, key, n) == 0) {
+            return entry->value;
+        }
+    }
+    return NULL;
+}
+
+// Adds a new reference to value under the key, unless the key is too long
+// or the cache is full.
+void value_cache_put(ValueCache *c, const unsigned char *key, const size_t n,
+        const uint64_t hash, PyObject *value) {
+    ValueCacheEntry *entry;
+    size_t i;
+    if (n > VALUE_CACHE_KEY_MAX || c->length >= VALUE_CACHE_MAX_ENTRIES) {
+        return;
+    }
+    for (i=hash & (VALUE_CACHE_SIZE-1); c->entries[i].value != NULL; i=(i+1) & (VALUE_CACHE_SIZE-1));
+    entry = &c->entries[i];
+    if ((entry->key = (unsigned char*)malloc(n > 0 ? n : 1)) == NULL) {
+        return;
+    }
+    memcpy(entry->key, key, n);
+    entry->hash = hash;
+    entry->length = n;
+    Py_INCREF(value);
+    entry->value = value;
+    c->length++;
+}
+
+void value_cache_free(ValueCache *c) {
+    size_t i;
+    if (c == NULL) {
+        return;
+    }
+    for (i=0; i<VALUE_CACHE_SIZE; i++) {
+        if (c->entries[i].value != NULL) {
+            free(c->entries[i].key);
+            Py_DECREF(c->entries[i].value);
+        }
+    }
+    free(c->entries);
+    free(c);
+}
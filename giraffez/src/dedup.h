@@ -0,0 +1,60 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_DEDUP_H
+#define __GIRAFFEZ_DEDUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+
+
+// Values with more raw bytes than this are decoded without the cache.
+#define VALUE_CACHE_KEY_MAX 64
+
+// A column stops adding values once the cache holds this many, so a
+// column with many distinct values costs a failed lookup per value at
+// most. The table is kept at twice this size.
+#define VALUE_CACHE_MAX_ENTRIES 1024
+
+typedef struct ValueCacheEntry {
+    uint64_t      hash;
+    size_t        length;
+    unsigned char *key;
+    PyObject      *value;
+} ValueCacheEntry;
+
+// An open addressing hash table mapping the raw bytes of a value to the
+// object decoded from them, so repeated values share a single object.
+typedef struct ValueCache {
+    size_t          length;
+    ValueCacheEntry *entries;
+} ValueCache;
+
+ValueCache* value_cache_new();
+PyObject*   value_cache_get(const ValueCache *c, const unsigned char *key, const size_t n,
+    uint64_t *hash);
+void        value_cache_put(ValueCache *c, const unsigned char *key, const size_t n,
+    const uint64_t hash, PyObject *value);
+void        value_cache_free(ValueCache *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
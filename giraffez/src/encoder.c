@@ -15,14 +15,292 @@
  */
 
 #include "common.h"
+#include "arrow.h"
 #include "buffer.h"
 #include "columns.h"
 #include "convert.h"
+#include "filter.h"
+#include "lazy.h"
 #include "row.h"
 
 #include "encoder.h"
 
 
+static uint16_t decode_opcode(const GiraffeColumn *column, const uint32_t settings) {
+    int giraffe_types = (settings & DATETIME_RETURN_MASK) == DATETIME_AS_GIRAFFE_TYPES;
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            return OP_BYTEINT;
+        case GD_SMALLINT:
+            return OP_SMALLINT;
+        case GD_INTEGER:
+            return OP_INTEGER;
+        case GD_BIGINT:
+            return OP_BIGINT;
+        case GD_FLOAT:
+            return OP_FLOAT;
+        case GD_DECIMAL:
+            switch (settings & DECIMAL_RETURN_MASK) {
+                case DECIMAL_AS_STRING:
+                    return OP_DECIMAL_AS_STRING;
+                case DECIMAL_AS_GIRAFFEZ_DECIMAL:
+                    return OP_DECIMAL_AS_GIRAFFEZ_DECIMAL;
+                case DECIMAL_AS_SCALED_INT:
+                    return OP_DECIMAL_AS_SCALED_INT;
+                default:
+                    return OP_DECIMAL_AS_FLOAT;
+            }
+        case GD_NUMBER:
+            switch (settings & DECIMAL_RETURN_MASK) {
+                case DECIMAL_AS_STRING:
+                    return OP_NUMBER_AS_STRING;
+                case DECIMAL_AS_GIRAFFEZ_DECIMAL:
+                    return OP_NUMBER_AS_GIRAFFEZ_DECIMAL;
+                case DECIMAL_AS_SCALED_INT:
+                    return OP_NUMBER_AS_SCALED_INT;
+                default:
+                    return OP_NUMBER_AS_FLOAT;
+            }
+        case GD_CHAR:
+            return (settings & CHAR_RETURN_MASK) == CHAR_AS_TRIMMED ? OP_CHAR_TRIMMED : OP_CHAR;
+        case GD_VARCHAR:
+            return OP_VARCHAR;
+        case GD_DATE:
+            return giraffe_types ? OP_DATE_AS_GIRAFFE_TYPES : OP_DATE_AS_STRING;
+        case GD_TIME:
+            return giraffe_types ? OP_TIME_AS_GIRAFFE_TYPES : OP_TIME_AS_STRING;
+        case GD_TIMESTAMP:
+            return giraffe_types ? OP_TIMESTAMP_AS_GIRAFFE_TYPES : OP_TIMESTAMP_AS_STRING;
+        case GD_BYTE:
+            return OP_BYTE;
+        case GD_VARBYTE:
+            return OP_VARBYTE;
+        default:
+            return OP_DEFAULT;
+    }
+}
+
+static void decode_plan_free(DecodePlan *plan) {
+    size_t i;
+    if (plan == NULL) {
+        return;
+    }
+    for (i=0; plan->caches != NULL && i<plan->ncolumns; i++) {
+        value_cache_free(plan->caches[i]);
+    }
+    free(plan->ops);
+    free(plan->columns);
+    free(plan->items);
+    free(plan->caches);
+    free(plan->keys);
+    free(plan->key_offsets);
+    free(plan);
+}
+
+static int names_contain(char **names, const size_t length, const GiraffeColumn *column) {
+    size_t i;
+    for (i=0; i<length; i++) {
+        if (compare_name(names[i], column->Name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void names_free(char **names, const size_t length) {
+    size_t i;
+    for (i=0; i<length; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+// Copies the column names in the sequence obj into names. When the columns
+// are set every name must be found in them.
+static int names_from_sequence(const TeradataEncoder *e, PyObject *obj, const char *message,
+        char ***names, size_t *length) {
+    PyObject *seq;
+    PyObject *item;
+    const char *name;
+    char **result = NULL;
+    Py_ssize_t i, n;
+    size_t j;
+    if ((seq = PySequence_Fast(obj, message)) == NULL) {
+        return -1;
+    }
+    n = PySequence_Fast_GET_SIZE(seq);
+    if (n > 0 && (result = (char**)calloc(n, sizeof(char*))) == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    for (i=0; i<n; i++) {
+        item = PySequence_Fast_GET_ITEM(seq, i);
+        if (!PyStr_Check(item)) {
+            PyErr_Format(EncoderError, "Column name must be a string, received '%s'",
+                Py_TYPE(item)->tp_name);
+            goto error;
+        }
+        if ((name = PyUnicode_AsUTF8(item)) == NULL) {
+            goto error;
+        }
+        for (j=0; e->Columns != NULL && j<e->Columns->length; j++) {
+            if (compare_name(name, e->Columns->array[j].Name) == 0) {
+                break;
+            }
+        }
+        if (e->Columns != NULL && j == e->Columns->length) {
+            PyErr_Format(EncoderError, "Column '%s' not found", name);
+            goto error;
+        }
+        result[i] = strdup(name);
+    }
+    Py_DECREF(seq);
+    *names = result;
+    *length = n;
+    return 0;
+error:
+    names_free(result, result != NULL ? n : 0);
+    Py_DECREF(seq);
+    return -1;
+}
+
+static int projection_contains(const TeradataEncoder *e, const GiraffeColumn *column) {
+    return e->ProjectionLength == 0 || names_contain(e->Projection, e->ProjectionLength, column);
+}
+
+static void projection_free(TeradataEncoder *e) {
+    names_free(e->Projection, e->ProjectionLength);
+    e->Projection = NULL;
+    e->ProjectionLength = 0;
+}
+
+static int dedup_contains(const TeradataEncoder *e, const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_CHAR:
+        case GD_VARCHAR:
+        case GD_DATE:
+            return e->DedupAll || names_contain(e->Dedup, e->DedupLength, column);
+        default:
+            return 0;
+    }
+}
+
+static void dedup_free(TeradataEncoder *e) {
+    names_free(e->Dedup, e->DedupLength);
+    e->Dedup = NULL;
+    e->DedupLength = 0;
+    e->DedupAll = 0;
+}
+
+// Builds the text written before each value of a row encoded as JSON, in
+// the same format as json.dumps: '{"col1": ' for the first column and
+// ', "col2": ' for the rest.
+static int decode_plan_compile_keys(DecodePlan *plan, const GiraffeColumns *columns) {
+    const char *title;
+    char *keys;
+    size_t i, n, size = 0;
+    for (i=0; i<plan->width; i++) {
+        size += strlen(columns->array[plan->columns[i]].Title) * 6 + 6;
+    }
+    if ((plan->keys = (char*)malloc(size + 1)) == NULL ||
+            (plan->key_offsets = (size_t*)malloc((plan->width + 1) * sizeof(size_t))) == NULL) {
+        return -1;
+    }
+    keys = plan->keys;
+    for (i=0; i<plan->width; i++) {
+        title = columns->array[plan->columns[i]].Title;
+        n = strlen(title);
+        plan->key_offsets[i] = keys - plan->keys;
+        if (i == 0) {
+            *keys++ = '{';
+        } else {
+            *keys++ = ',';
+            *keys++ = ' ';
+        }
+        *keys++ = '"';
+        keys += json_escape(keys, title, n);
+        *keys++ = '"';
+        *keys++ = ':';
+        *keys++ = ' ';
+    }
+    plan->key_offsets[plan->width] = keys - plan->keys;
+    return 0;
+}
+
+// The decode plan is rebuilt whenever the columns, the settings, the
+// projection or the deduplicated columns change. Adjacent columns sharing
+// an opcode are fused into a single instruction so that wide tables of
+// similar types are decoded in tight loops.
+static int encoder_compile_plan(TeradataEncoder *e) {
+    DecodePlan *plan;
+    DecodeOp *op;
+    GiraffeColumn *column;
+    uint16_t opcode;
+    size_t i;
+    decode_plan_free(e->Plan);
+    e->Plan = NULL;
+    Py_CLEAR(e->RowSchema);
+    Py_CLEAR(e->RowType);
+    if (e->Columns == NULL) {
+        return 0;
+    }
+    if ((plan = (DecodePlan*)malloc(sizeof(DecodePlan))) == NULL) {
+        return -1;
+    }
+    plan->length = 0;
+    plan->width = 0;
+    plan->ops = (DecodeOp*)malloc(sizeof(DecodeOp) * (e->Columns->length+1));
+    plan->columns = (size_t*)malloc(sizeof(size_t) * (e->Columns->length+1));
+    plan->items = (PyObject**)calloc(e->Columns->length+1, sizeof(PyObject*));
+    plan->ncolumns = e->Columns->length;
+    plan->caches = NULL;
+    plan->keys = NULL;
+    plan->key_offsets = NULL;
+    if (plan->ops == NULL || plan->columns == NULL || plan->items == NULL) {
+        decode_plan_free(plan);
+        return -1;
+    }
+    if ((e->DedupAll || e->DedupLength > 0) &&
+            (plan->caches = (ValueCache**)calloc(e->Columns->length, sizeof(ValueCache*))) == NULL) {
+        decode_plan_free(plan);
+        return -1;
+    }
+    for (i=0; i<e->Columns->length; i++) {
+        column = &e->Columns->array[i];
+        if (projection_contains(e, column)) {
+            opcode = decode_opcode(column, e->Settings);
+            if (plan->caches != NULL && dedup_contains(e, column)) {
+                if ((plan->caches[i] = value_cache_new()) == NULL) {
+                    decode_plan_free(plan);
+                    return -1;
+                }
+                opcode = OP_CACHED;
+            }
+            plan->columns[plan->width++] = i;
+        } else {
+            opcode = column_is_fixed(column) ? OP_SKIP_FIXED : OP_SKIP;
+        }
+        if (plan->length > 0 && plan->ops[plan->length-1].Opcode == opcode) {
+            plan->ops[plan->length-1].Count++;
+            plan->ops[plan->length-1].Length += column->Length;
+            continue;
+        }
+        op = &plan->ops[plan->length++];
+        op->Opcode = opcode;
+        op->Column = i;
+        op->Count = 1;
+        op->Item = plan->width - (opcode < OP_SKIP ? 1 : 0);
+        op->Length = column->Length;
+    }
+    if ((e->Settings & ROW_RETURN_MASK) == ROW_ENCODING_JSON &&
+            decode_plan_compile_keys(plan, e->Columns) != 0) {
+        decode_plan_free(plan);
+        return -1;
+    }
+    e->Plan = plan;
+    return 0;
+}
+
 TeradataEncoder* encoder_new(GiraffeColumns *columns, uint32_t settings) {
     TeradataEncoder *e;
     e = (TeradataEncoder*)malloc(sizeof(TeradataEncoder));
@@ -30,13 +308,25 @@ TeradataEncoder* encoder_new(GiraffeColumns *columns, uint32_t settings) {
         settings = ENCODER_SETTINGS_DEFAULT;
     }
     e->Columns = columns;
+    e->Plan = NULL;
+    e->RowSchema = NULL;
+    e->RowType = NULL;
     e->Settings = settings;
     e->Delimiter = NULL;
     e->NullValue = NULL;
+    e->Projection = NULL;
+    e->ProjectionLength = 0;
+    e->Predicates = NULL;
+    e->Filter = NULL;
+    e->Dedup = NULL;
+    e->DedupLength = 0;
+    e->DedupAll = 0;
     e->DelimiterStr = NULL;
     e->NullValueStr = NULL;
     e->DelimiterStrLen = 0;
     e->NullValueStrLen = 0;
+    e->Quoting = 0;
+    e->Busy = 0;
     e->buffer = buffer_new(TD_ROW_MAX_SIZE);
     e->PackRowFunc = NULL;
     e->PackItemFunc = NULL;
@@ -54,6 +344,9 @@ TeradataEncoder* encoder_new(GiraffeColumns *columns, uint32_t settings) {
 }
 
 int encoder_set_encoding(TeradataEncoder *e, uint32_t settings) {
+    if (encoder_check_idle(e) != 0) {
+        return -1;
+    }
     // to switch on the value we just mask the particular byte
     switch (settings & ROW_RETURN_MASK) {
         case ROW_ENCODING_STRING:
@@ -84,6 +377,34 @@ int encoder_set_encoding(TeradataEncoder *e, uint32_t settings) {
             e->PackRowFunc = teradata_row_from_pybytes;
             e->PackItemFunc = teradata_item_from_pyobject;
             break;
+        case ROW_ENCODING_ARROW:
+            e->UnpackRowsFunc = teradata_buffer_to_arrow;
+            e->UnpackRowFunc = teradata_row_to_pytuple;
+            e->UnpackItemFunc = teradata_item_to_pyobject;
+            e->PackRowFunc = teradata_row_from_pytuple;
+            e->PackItemFunc = teradata_item_from_pyobject;
+            break;
+        case ROW_ENCODING_LAZY:
+            e->UnpackRowsFunc = teradata_buffer_to_lazyrows;
+            e->UnpackRowFunc = teradata_row_to_pytuple;
+            e->UnpackItemFunc = teradata_item_to_pyobject;
+            e->PackRowFunc = teradata_row_from_pytuple;
+            e->PackItemFunc = teradata_item_from_pyobject;
+            break;
+        case ROW_ENCODING_NAMEDTUPLE:
+            e->UnpackRowsFunc = teradata_buffer_to_pylist;
+            e->UnpackRowFunc = teradata_row_to_pynamedtuple;
+            e->UnpackItemFunc = teradata_item_to_pyobject;
+            e->PackRowFunc = teradata_row_from_pytuple;
+            e->PackItemFunc = teradata_item_from_pyobject;
+            break;
+        case ROW_ENCODING_JSON:
+            e->UnpackRowsFunc = teradata_buffer_to_pylist;
+            e->UnpackRowFunc = teradata_row_to_pyjson;
+            e->UnpackItemFunc = teradata_item_to_pyobject;
+            e->PackRowFunc = teradata_row_from_pydict;
+            e->PackItemFunc = teradata_item_from_pyobject;
+            break;
         default:
             return -1;
     }
@@ -111,11 +432,47 @@ int encoder_set_encoding(TeradataEncoder *e, uint32_t settings) {
         case DECIMAL_AS_GIRAFFEZ_DECIMAL:
             e->UnpackDecimalFunc = cstring_to_giraffez_decimal;
             break;
+        case DECIMAL_AS_SCALED_INT:
+            e->UnpackDecimalFunc = cstring_to_pylong;
+            break;
+        default:
+            return -1;
+    }
+    switch (settings & CHAR_RETURN_MASK) {
+        case 0:
+        case CHAR_AS_PADDED:
+        case CHAR_AS_TRIMMED:
+            break;
         default:
             return -1;
     }
     e->Settings = settings;
-    return 0;
+    return encoder_compile_plan(e);
+}
+
+// A filter that no longer compiles against new columns is kept unset, and
+// teradata_buffer_to_pylist reports the error rather than returning
+// unfiltered rows.
+static void encoder_compile_filter(TeradataEncoder *e) {
+    filter_free(e->Filter);
+    e->Filter = NULL;
+    if (e->Predicates == NULL || e->Columns == NULL) {
+        return;
+    }
+    if ((e->Filter = filter_compile(e->Columns, e->Predicates)) == NULL) {
+        PyErr_Clear();
+    }
+}
+
+// Takes the columns, which the caller must have checked can be replaced
+// with encoder_check_idle. The plan is rebuilt before the filter, since
+// compiling the filter can run Python code that lets another thread decode.
+int encoder_set_columns(TeradataEncoder *e, GiraffeColumns *columns) {
+    int status;
+    e->Columns = columns;
+    status = encoder_compile_plan(e);
+    encoder_compile_filter(e);
+    return status;
 }
 
 PyObject* encoder_set_delimiter(TeradataEncoder *e, PyObject *obj) {
@@ -160,6 +517,7 @@ PyObject* encoder_set_null(TeradataEncoder *e, PyObject *obj) {
     Py_XDECREF(e->NullValue);
     Py_INCREF(obj);
     e->NullValue = obj;
+    Py_CLEAR(e->RowSchema);
     if (PyStr_Check(obj)) {
         if ((null = (char*)PyUnicode_AsUTF8(obj)) == NULL) {
             return NULL;
@@ -183,7 +541,118 @@ PyObject* encoder_set_null(TeradataEncoder *e, PyObject *obj) {
     Py_RETURN_NONE;
 }
 
+// Quotes values written as text that contain the delimiter, a double quote
+// or a line break, doubling any double quotes, as described by RFC 4180.
+PyObject* encoder_set_quoting(TeradataEncoder *e, PyObject *obj) {
+    int quoting;
+    if ((quoting = PyObject_IsTrue(obj)) < 0) {
+        return NULL;
+    }
+    e->Quoting = quoting;
+    Py_RETURN_NONE;
+}
+
+// Restricts the rows built by UnpackRowFunc to the named columns, which are
+// returned in the order they appear in the columns. Passing None or an empty
+// sequence selects every column again.
+PyObject* encoder_set_projection(TeradataEncoder *e, PyObject *obj) {
+    char **projection = NULL;
+    size_t n = 0;
+    if (obj != NULL && obj != Py_None) {
+        if (names_from_sequence(e, obj, "Projection must be a sequence of column names",
+                &projection, &n) != 0) {
+            return NULL;
+        }
+    }
+    // Reading the names can run Python code, so this is checked only after
+    if (encoder_check_idle(e) != 0) {
+        names_free(projection, n);
+        return NULL;
+    }
+    projection_free(e);
+    e->Projection = projection;
+    e->ProjectionLength = n;
+    if (encoder_compile_plan(e) != 0) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+// Shares the objects decoded from repeated values of the CHAR, VARCHAR and
+// DATE columns named in the sequence obj, or of every such column when obj
+// is True. Values are cached by their raw bytes, per column, until the
+// decode plan is rebuilt. Passing None or False stops caching values.
+PyObject* encoder_set_dedup(TeradataEncoder *e, PyObject *obj) {
+    char **names = NULL;
+    size_t n = 0;
+    int all = 0;
+    if (obj == Py_True) {
+        all = 1;
+    } else if (obj != NULL && obj != Py_None && obj != Py_False) {
+        if (names_from_sequence(e, obj, "Dedup must be a boolean or a sequence of column names",
+                &names, &n) != 0) {
+            return NULL;
+        }
+    }
+    if (encoder_check_idle(e) != 0) {
+        names_free(names, n);
+        return NULL;
+    }
+    dedup_free(e);
+    e->Dedup = names;
+    e->DedupLength = n;
+    e->DedupAll = all;
+    if (encoder_compile_plan(e) != 0) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+// Sets the predicates that rows must match to be returned by
+// teradata_buffer_to_pylist (see filter_compile). Passing None removes the
+// filter.
+PyObject* encoder_set_filter(TeradataEncoder *e, PyObject *obj) {
+    RowFilter *f = NULL;
+    if (obj == Py_None) {
+        obj = NULL;
+    }
+    if (obj != NULL && e->Columns != NULL) {
+        Py_RETURN_ERROR(f = filter_compile(e->Columns, obj));
+    }
+    Py_XINCREF(obj);
+    Py_XDECREF(e->Predicates);
+    e->Predicates = obj;
+    filter_free(e->Filter);
+    e->Filter = f;
+    Py_RETURN_NONE;
+}
+
+// Decoding releases the GIL while walking the columns and the decode plan,
+// so they are held until it reacquires it, and the setters that would
+// free them raise in the meantime rather than wait.
+void encoder_hold(const TeradataEncoder *e) {
+    ((TeradataEncoder*)e)->Busy++;
+}
+
+void encoder_release(const TeradataEncoder *e) {
+    ((TeradataEncoder*)e)->Busy--;
+}
+
+int encoder_check_idle(const TeradataEncoder *e) {
+    if (e->Busy > 0) {
+        PyErr_SetString(EncoderError, "Encoder cannot be changed while rows are being decoded");
+        return -1;
+    }
+    return 0;
+}
+
 void encoder_clear(TeradataEncoder *e) {
+    if (e != NULL) {
+        decode_plan_free(e->Plan);
+        filter_free(e->Filter);
+        e->Plan = NULL;
+        e->Filter = NULL;
+    }
     if (e != NULL && e->Columns != NULL) {
         columns_free(e->Columns);
         e->Columns = NULL;
@@ -196,9 +665,15 @@ void encoder_free(TeradataEncoder *e) {
     }
     Py_XDECREF(e->Delimiter);
     Py_XDECREF(e->NullValue);
+    Py_XDECREF(e->Predicates);
+    Py_XDECREF(e->RowSchema);
+    Py_XDECREF(e->RowType);
     e->Delimiter = NULL;
     e->NullValue = NULL;
+    e->Predicates = NULL;
     encoder_clear(e);
+    projection_free(e);
+    dedup_free(e);
     free(e->DelimiterStr);
     free(e->NullValueStr);
     if (e->buffer != NULL) {
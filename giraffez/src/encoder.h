@@ -24,6 +24,8 @@ extern "C" {
 #include "common.h"
 #include "columns.h"
 #include "buffer.h"
+#include "dedup.h"
+#include "filter.h"
 
 
 enum RowEncodingType {
@@ -32,6 +34,10 @@ enum RowEncodingType {
     ROW_ENCODING_DICT     = 0x02,
     ROW_ENCODING_LIST     = 0x04,
     ROW_ENCODING_RAW      = 0x08,
+    ROW_ENCODING_ARROW    = 0x10,
+    ROW_ENCODING_LAZY     = 0x20,
+    ROW_ENCODING_NAMEDTUPLE = 0x40,
+    ROW_ENCODING_JSON     = 0x80,
     ROW_RETURN_MASK       = 0xff,
 };
 
@@ -47,20 +53,115 @@ enum DecimalReturnType {
     DECIMAL_AS_STRING           = 0x010000,
     DECIMAL_AS_FLOAT            = 0x020000,
     DECIMAL_AS_GIRAFFEZ_DECIMAL = 0x040000,
+    DECIMAL_AS_SCALED_INT       = 0x080000,
     DECIMAL_RETURN_MASK         = 0xff0000,
 };
 
+// CHAR values are returned as received unless CHAR_AS_TRIMMED is set, so
+// settings without any of these bits are the same as CHAR_AS_PADDED. The
+// mask is defined separately as it does not fit in an enum.
+enum CharReturnType {
+    CHAR_AS_PADDED              = 0x01000000,
+    CHAR_AS_TRIMMED             = 0x02000000,
+};
+#define CHAR_RETURN_MASK 0xff000000U
+
+// Opcodes of the decode plan compiled from the columns and the encoder
+// settings. The decimal and datetime opcodes are resolved against the
+// settings when the plan is compiled so that the row loop calls the
+// converter directly rather than through a function pointer.
+enum DecodeOpcode {
+    OP_BYTEINT = 0,
+    OP_SMALLINT,
+    OP_INTEGER,
+    OP_BIGINT,
+    OP_FLOAT,
+    OP_DECIMAL_AS_STRING,
+    OP_DECIMAL_AS_FLOAT,
+    OP_DECIMAL_AS_GIRAFFEZ_DECIMAL,
+    OP_DECIMAL_AS_SCALED_INT,
+    OP_NUMBER_AS_STRING,
+    OP_NUMBER_AS_FLOAT,
+    OP_NUMBER_AS_GIRAFFEZ_DECIMAL,
+    OP_NUMBER_AS_SCALED_INT,
+    OP_CHAR,
+    OP_CHAR_TRIMMED,
+    OP_VARCHAR,
+    OP_DATE_AS_STRING,
+    OP_DATE_AS_GIRAFFE_TYPES,
+    OP_TIME_AS_STRING,
+    OP_TIME_AS_GIRAFFE_TYPES,
+    OP_TIMESTAMP_AS_STRING,
+    OP_TIMESTAMP_AS_GIRAFFE_TYPES,
+    OP_BYTE,
+    OP_VARBYTE,
+    OP_CACHED,
+    OP_DEFAULT,
+    OP_SKIP,
+    OP_SKIP_FIXED
+};
+
+// A single instruction covers Count adjacent columns, starting at Column,
+// that share the same opcode. The values are stored into the row starting
+// at Item. Columns left out of the projection are compiled to skips, and
+// adjacent fixed width skips are fused into a single jump of Length bytes.
+typedef struct DecodeOp {
+    uint16_t Opcode;
+    size_t   Column;
+    size_t   Count;
+    size_t   Item;
+    uint64_t Length;
+} DecodeOp;
+
+// width is the number of columns in a decoded row and columns maps each
+// of them back to its position in the encoder columns.
+typedef struct DecodePlan {
+    size_t   length;
+    size_t   width;
+    DecodeOp *ops;
+    size_t   *columns;
+    PyObject **items;
+
+    // The value caches of the columns compiled to OP_CACHED, indexed by
+    // the position of the column among the ncolumns the plan was compiled
+    // for, or NULL when no column is cached.
+    size_t     ncolumns;
+    ValueCache **caches;
+
+    // When rows are encoded as JSON, the object key of each decoded column
+    // escaped and quoted, along with the text written before and after it,
+    // with key_offsets[i] the start of that of column i in keys.
+    char       *keys;
+    size_t     *key_offsets;
+} DecodePlan;
+
 typedef struct TeradataEncoder {
     GiraffeColumns *Columns;
+    DecodePlan     *Plan;
     PyObject       *Delimiter;
     PyObject       *NullValue;
+    char           **Projection;
+    size_t         ProjectionLength;
+    PyObject       *Predicates;
+    RowFilter      *Filter;
+    char           **Dedup;
+    size_t         DedupLength;
+    int            DedupAll;
+    PyObject       *RowSchema;
+    PyObject       *RowType;
     uint32_t       Settings;
     size_t         DelimiterStrLen;
     char           *DelimiterStr;
     size_t         NullValueStrLen;
     char           *NullValueStr;
+    int            Quoting;
     buffer_t       *buffer;
 
+    // The number of decodes walking Columns and Plan with the GIL released
+    // (see encoder_hold). The settings that would free them cannot be
+    // changed while it is non-zero.
+    int            Busy;
+
     GiraffeColumns *(*UnpackStmtInfoFunc)  (unsigned char**, const uint32_t);
 
     PyObject *(*PackRowFunc)  (const struct TeradataEncoder*, PyObject*, unsigned char**, uint16_t*);
@@ -80,9 +181,17 @@ typedef PyObject *(*EncoderFunc)(const TeradataEncoder*, unsigned char**, const
 
 TeradataEncoder* encoder_new(GiraffeColumns *columns, uint32_t settings);
 int              encoder_set_encoding(TeradataEncoder *e, uint32_t settings);
+int              encoder_set_columns(TeradataEncoder *e, GiraffeColumns *columns);
 PyObject*        encoder_set_delimiter(TeradataEncoder *e, PyObject *obj);
 PyObject*        encoder_set_null(TeradataEncoder *e, PyObject *obj);
+PyObject*        encoder_set_quoting(TeradataEncoder *e, PyObject *obj);
+PyObject*        encoder_set_dedup(TeradataEncoder *e, PyObject *obj);
+PyObject*        encoder_set_projection(TeradataEncoder *e, PyObject *obj);
+PyObject*        encoder_set_filter(TeradataEncoder *e, PyObject *obj);
 void             encoder_clear(TeradataEncoder *e);
+void             encoder_hold(const TeradataEncoder *e);
+void             encoder_release(const TeradataEncoder *e);
+int              encoder_check_idle(const TeradataEncoder *e);
 void             encoder_free(TeradataEncoder *e);
 
 #ifdef __cplusplus
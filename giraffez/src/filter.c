@@ -0,0 +1,491 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "columns.h"
+#include "convert.h"
+
+#include "filter.h"
+
+
+enum FilterKind {
+    FILTER_UNSUPPORTED = 0,
+    FILTER_INT64,
+    FILTER_DOUBLE,
+    FILTER_BYTES
+};
+
+static int filter_kind(const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_BYTEINT:
+        case GD_SMALLINT:
+        case GD_INTEGER:
+        case GD_BIGINT:
+        case GD_DATE:
+            return FILTER_INT64;
+        case GD_DECIMAL:
+            return column->Length <= sizeof(int64_t) ? FILTER_INT64 : FILTER_UNSUPPORTED;
+        case GD_FLOAT:
+            return FILTER_DOUBLE;
+        case GD_NUMBER:
+            return FILTER_UNSUPPORTED;
+        default:
+            return FILTER_BYTES;
+    }
+}
+
+// Fixed width character columns are padded with spaces, so trailing spaces
+// are ignored on both sides of the comparison.
+static int filter_is_padded(const GiraffeColumn *column) {
+    switch (column->GDType) {
+        case GD_DEFAULT:
+        case GD_CHAR:
+        case GD_TIME:
+        case GD_TIMESTAMP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int compare_int64(const void *l, const void *r) {
+    int64_t a = ((const FilterValue*)l)->q, b = ((const FilterValue*)r)->q;
+    return (a > b) - (a < b);
+}
+
+static int compare_double(const void *l, const void *r) {
+    double a = ((const FilterValue*)l)->d, b = ((const FilterValue*)r)->d;
+    return (a > b) - (a < b);
+}
+
+static int compare_bytes(const void *l, const void *r) {
+    const FilterValue *a = (const FilterValue*)l, *b = (const FilterValue*)r;
+    int c = memcmp(a->s, b->s, a->n < b->n ? a->n : b->n);
+    if (c != 0) {
+        return c;
+    }
+    return (a->n > b->n) - (a->n < b->n);
+}
+
+static void filter_read(const GiraffeColumn *column, unsigned char *data, FilterValue *v) {
+    int8_t b; int16_t h; int32_t l; uint16_t H;
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            unpack_int8_t(&data, &b);
+            v->q = b;
+            break;
+        case GD_SMALLINT:
+            unpack_int16_t(&data, &h);
+            v->q = h;
+            break;
+        case GD_INTEGER:
+        case GD_DATE:
+            unpack_int32_t(&data, &l);
+            v->q = l;
+            break;
+        case GD_BIGINT:
+            unpack_int64_t(&data, &v->q);
+            break;
+        case GD_DECIMAL:
+            switch (column->Length) {
+                case 1:
+                    unpack_int8_t(&data, &b);
+                    v->q = b;
+                    break;
+                case 2:
+                    unpack_int16_t(&data, &h);
+                    v->q = h;
+                    break;
+                case 4:
+                    unpack_int32_t(&data, &l);
+                    v->q = l;
+                    break;
+                default:
+                    unpack_int64_t(&data, &v->q);
+            }
+            break;
+        case GD_FLOAT:
+            unpack_float(&data, &v->d);
+            break;
+        case GD_VARCHAR:
+        case GD_VARBYTE:
+            unpack_uint16_t(&data, &H);
+            v->s = (const char*)data;
+            v->n = H;
+            break;
+        default:
+            v->s = (const char*)data;
+            v->n = column->Length;
+    }
+    if (filter_is_padded(column)) {
+        while (v->n > 0 && v->s[v->n-1] == ' ') {
+            v->n--;
+        }
+    }
+}
+
+static int decimal_from_pyobject(PyObject *obj, const GiraffeColumn *column, int64_t *q) {
+    PyObject *s;
+    const char *str, *p;
+    int negative = 0, point = 0, digits = 0;
+    uint16_t fraction = 0;
+    int64_t v = 0;
+    if ((s = PyObject_Str(obj)) == NULL) {
+        return -1;
+    }
+    if ((str = PyUnicode_AsUTF8(s)) == NULL) {
+        Py_DECREF(s);
+        return -1;
+    }
+    p = str;
+    if (*p == '-' || *p == '+') {
+        negative = *p++ == '-';
+    }
+    for (; *p; p++) {
+        if (*p == '.' && !point) {
+            point = 1;
+            continue;
+        }
+        if (!isdigit((unsigned char)*p)) {
+            goto invalid;
+        }
+        // digits beyond the scale of the column can only be zeros
+        if (point && fraction == column->Scale) {
+            if (*p != '0') {
+                goto invalid;
+            }
+            continue;
+        }
+        if (v > (INT64_MAX - 9) / 10) {
+            goto invalid;
+        }
+        v = v * 10 + (*p - '0');
+        digits++;
+        fraction += point;
+    }
+    if (digits == 0) {
+        goto invalid;
+    }
+    for (; fraction < column->Scale; fraction++) {
+        if (v > INT64_MAX / 10) {
+            goto invalid;
+        }
+        v *= 10;
+    }
+    *q = negative ? -v : v;
+    Py_DECREF(s);
+    return 0;
+invalid:
+    PyErr_Format(EncoderError, "Value '%s' cannot be compared with column '%s'", str, column->Name);
+    Py_DECREF(s);
+    return -1;
+}
+
+static int date_from_pyobject(PyObject *obj, const GiraffeColumn *column, int64_t *q) {
+    PyObject *attr;
+    const char *str;
+    const char *names[] = {"year", "month", "day"};
+    long parts[3];
+    int i;
+    if (PyStr_Check(obj)) {
+        if ((str = PyUnicode_AsUTF8(obj)) == NULL) {
+            return -1;
+        }
+        if (sscanf(str, "%ld-%ld-%ld", &parts[0], &parts[1], &parts[2]) != 3) {
+            PyErr_Format(EncoderError, "Value '%s' cannot be compared with column '%s'", str,
+                column->Name);
+            return -1;
+        }
+    } else {
+        for (i=0; i<3; i++) {
+            if ((attr = PyObject_GetAttrString(obj, names[i])) == NULL) {
+                return -1;
+            }
+            parts[i] = PyLong_AsLong(attr);
+            Py_DECREF(attr);
+            if (parts[i] == -1 && PyErr_Occurred()) {
+                return -1;
+            }
+        }
+    }
+    *q = (parts[0] - 1900) * 10000 + parts[1] * 100 + parts[2];
+    return 0;
+}
+
+static int bytes_from_pyobject(PyObject *obj, const GiraffeColumn *column, FilterValue *v) {
+    char *str;
+    Py_ssize_t n;
+    char *s;
+    if (PyBytes_Check(obj)) {
+        if (PyBytes_AsStringAndSize(obj, &str, &n) != 0) {
+            return -1;
+        }
+    } else if (PyStr_Check(obj)) {
+        if ((str = (char*)PyUnicode_AsUTF8AndSize(obj, &n)) == NULL) {
+            return -1;
+        }
+    } else {
+        PyErr_Format(EncoderError, "Value of type '%s' cannot be compared with column '%s'",
+            Py_TYPE(obj)->tp_name, column->Name);
+        return -1;
+    }
+    if (filter_is_padded(column)) {
+        while (n > 0 && str[n-1] == ' ') {
+            n--;
+        }
+    }
+    if ((s = (char*)malloc(n > 0 ? n : 1)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(s, str, n);
+    v->s = s;
+    v->n = n;
+    return 0;
+}
+
+static int value_from_pyobject(PyObject *obj, const GiraffeColumn *column, FilterValue *v) {
+    switch (filter_kind(column)) {
+        case FILTER_DOUBLE:
+            v->d = PyFloat_AsDouble(obj);
+            return (v->d == -1.0 && PyErr_Occurred()) ? -1 : 0;
+        case FILTER_BYTES:
+            return bytes_from_pyobject(obj, column, v);
+    }
+    switch (column->GDType) {
+        case GD_DATE:
+            return date_from_pyobject(obj, column, &v->q);
+        case GD_DECIMAL:
+            return decimal_from_pyobject(obj, column, &v->q);
+        default:
+            v->q = PyLong_AsLongLong(obj);
+            return (v->q == -1 && PyErr_Occurred()) ? -1 : 0;
+    }
+}
+
+static int filter_op(const char *op) {
+    const char *ops[] = {"=", "!=", "<", "<=", ">", ">=", "is null", "is not null", "in"};
+    size_t i;
+    if (strcmp(op, "==") == 0) {
+        return FILTER_EQ;
+    }
+    if (strcmp(op, "<>") == 0) {
+        return FILTER_NE;
+    }
+    for (i=0; i<sizeof(ops)/sizeof(ops[0]); i++) {
+        if (compare_name(op, ops[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int predicate_compile(const GiraffeColumns *columns, PyObject *obj, FilterPredicate *p) {
+    PyObject *item;
+    PyObject *values = NULL;
+    const GiraffeColumn *column;
+    const char *name, *op;
+    Py_ssize_t i, n;
+    int opcode, kind;
+    if ((item = PySequence_Fast(obj, "Filter predicates must be tuples")) == NULL) {
+        return -1;
+    }
+    n = PySequence_Fast_GET_SIZE(item);
+    if (n < 2 || n > 3) {
+        PyErr_SetString(EncoderError, "Filter predicates must be (column, op) or (column, op, value)");
+        goto error;
+    }
+    if ((name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(item, 0))) == NULL ||
+            (op = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(item, 1))) == NULL) {
+        goto error;
+    }
+    for (p->Column=0; p->Column<columns->length; p->Column++) {
+        if (compare_name(name, columns->array[p->Column].Name) == 0) {
+            break;
+        }
+    }
+    if (p->Column == columns->length) {
+        PyErr_Format(EncoderError, "Column '%s' not found", name);
+        goto error;
+    }
+    column = &columns->array[p->Column];
+    if ((opcode = filter_op(op)) < 0) {
+        PyErr_Format(EncoderError, "Unknown filter operator '%s'", op);
+        goto error;
+    }
+    p->Op = opcode;
+    if (p->Op == FILTER_IS_NULL || p->Op == FILTER_IS_NOT_NULL) {
+        Py_DECREF(item);
+        return 0;
+    }
+    if (n != 3) {
+        PyErr_Format(EncoderError, "Filter operator '%s' requires a value", op);
+        goto error;
+    }
+    if ((kind = filter_kind(column)) == FILTER_UNSUPPORTED) {
+        PyErr_Format(EncoderError, "Column '%s' cannot be filtered", column->Name);
+        goto error;
+    }
+    p->Compare = kind == FILTER_INT64 ? compare_int64 : kind == FILTER_DOUBLE ? compare_double : compare_bytes;
+    if (p->Op == FILTER_IN) {
+        if ((values = PySequence_Fast(PySequence_Fast_GET_ITEM(item, 2), "IN requires an iterable")) == NULL) {
+            goto error;
+        }
+    } else {
+        if ((values = PyTuple_Pack(1, PySequence_Fast_GET_ITEM(item, 2))) == NULL) {
+            goto error;
+        }
+    }
+    n = PySequence_Fast_GET_SIZE(values);
+    if ((p->Values = (FilterValue*)calloc(n > 0 ? n : 1, sizeof(FilterValue))) == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    for (i=0; i<n; i++) {
+        if (value_from_pyobject(PySequence_Fast_GET_ITEM(values, i), column, &p->Values[i]) != 0) {
+            goto error;
+        }
+        p->Count++;
+    }
+    if (p->Op == FILTER_IN) {
+        qsort(p->Values, p->Count, sizeof(FilterValue), p->Compare);
+    }
+    Py_DECREF(values);
+    Py_DECREF(item);
+    return 0;
+error:
+    Py_XDECREF(values);
+    Py_DECREF(item);
+    return -1;
+}
+
+// Compiles a sequence of (column, op) and (column, op, value) tuples against
+// the columns. The supported operators are the comparisons =, !=, <, <=, >
+// and >=, 'is null', 'is not null' and 'in', which takes an iterable of
+// values.
+RowFilter* filter_compile(const GiraffeColumns *columns, PyObject *obj) {
+    PyObject *seq;
+    RowFilter *f;
+    Py_ssize_t i, n;
+    if (columns == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before filtering rows");
+        return NULL;
+    }
+    Py_RETURN_ERROR(seq = PySequence_Fast(obj, "Filter must be a sequence of predicates"));
+    n = PySequence_Fast_GET_SIZE(seq);
+    if ((f = (RowFilter*)malloc(sizeof(RowFilter))) == NULL) {
+        Py_DECREF(seq);
+        return (RowFilter*)PyErr_NoMemory();
+    }
+    f->length = 0;
+    if ((f->predicates = (FilterPredicate*)calloc(n > 0 ? n : 1, sizeof(FilterPredicate))) == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    for (i=0; i<n; i++) {
+        f->length++;
+        if (predicate_compile(columns, PySequence_Fast_GET_ITEM(seq, i), &f->predicates[i]) != 0) {
+            goto error;
+        }
+    }
+    Py_DECREF(seq);
+    return f;
+error:
+    Py_DECREF(seq);
+    filter_free(f);
+    return NULL;
+}
+
+// Evaluates the filter against a row starting with the indicator header,
+// reading only the columns referenced by the predicates. Comparisons with
+// a null value do not match.
+int filter_match(const RowFilter *f, const GiraffeColumns *columns, unsigned char *row) {
+    const FilterPredicate *p;
+    FilterValue v;
+    size_t i;
+    int null, c;
+    for (i=0; i<f->length; i++) {
+        p = &f->predicates[i];
+        null = indicator_is_null(row, p->Column);
+        if (p->Op == FILTER_IS_NULL || p->Op == FILTER_IS_NOT_NULL) {
+            if (!null != (p->Op == FILTER_IS_NOT_NULL)) {
+                return 0;
+            }
+            continue;
+        }
+        if (null) {
+            return 0;
+        }
+        filter_read(&columns->array[p->Column], columns_locate(columns, row, p->Column), &v);
+        if (p->Op == FILTER_IN) {
+            if (bsearch(&v, p->Values, p->Count, sizeof(FilterValue), p->Compare) == NULL) {
+                return 0;
+            }
+            continue;
+        }
+        c = p->Compare(&v, &p->Values[0]);
+        switch (p->Op) {
+            case FILTER_EQ:
+                if (c != 0) {
+                    return 0;
+                }
+                break;
+            case FILTER_NE:
+                if (c == 0) {
+                    return 0;
+                }
+                break;
+            case FILTER_LT:
+                if (c >= 0) {
+                    return 0;
+                }
+                break;
+            case FILTER_LE:
+                if (c > 0) {
+                    return 0;
+                }
+                break;
+            case FILTER_GT:
+                if (c <= 0) {
+                    return 0;
+                }
+                break;
+            case FILTER_GE:
+                if (c < 0) {
+                    return 0;
+                }
+                break;
+        }
+    }
+    return 1;
+}
+
+void filter_free(RowFilter *f) {
+    FilterPredicate *p;
+    size_t i, j;
+    if (f == NULL) {
+        return;
+    }
+    for (i=0; f->predicates != NULL && i<f->length; i++) {
+        p = &f->predicates[i];
+        for (j=0; p->Compare == compare_bytes && j<p->Count; j++) {
+            free((char*)p->Values[j].s);
+        }
+        free(p->Values);
+    }
+    free(f->predicates);
+    free(f);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_FILTER_H
+#define __GIRAFFEZ_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include "columns.h"
+
+
+enum FilterOp {
+    FILTER_EQ = 0,
+    FILTER_NE,
+    FILTER_LT,
+    FILTER_LE,
+    FILTER_GT,
+    FILTER_GE,
+    FILTER_IS_NULL,
+    FILTER_IS_NOT_NULL,
+    FILTER_IN
+};
+
+// A value read from the wire or converted from a predicate constant.
+// Integers, dates and decimals (as scaled integers) are compared as q,
+// floats as d and everything else as the bytes s of length n.
+typedef struct FilterValue {
+    int64_t    q;
+    double     d;
+    const char *s;
+    size_t     n;
+} FilterValue;
+
+// A predicate holds a single constant, or the sorted constants of an IN
+// set, converted to the wire representation of its column.
+typedef struct FilterPredicate {
+    size_t      Column;
+    uint16_t    Op;
+    size_t      Count;
+    FilterValue *Values;
+    int         (*Compare)(const void*, const void*);
+} FilterPredicate;
+
+// The predicates of a filter are all required to match (AND).
+typedef struct RowFilter {
+    size_t          length;
+    FilterPredicate *predicates;
+} RowFilter;
+
+RowFilter* filter_compile(const GiraffeColumns *columns, PyObject *obj);
+int        filter_match(const RowFilter *f, const GiraffeColumns *columns, unsigned char *row);
+void       filter_free(RowFilter *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
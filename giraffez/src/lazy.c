@@ -0,0 +1,319 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "columns.h"
+#include "encoder.h"
+#include "row.h"
+
+#include "lazy.h"
+
+
+static PyObject* row_schema_new(const TeradataEncoder *e) {
+    RowSchema *s;
+    GiraffeColumn *column;
+    PyObject *index;
+    const char *key;
+    size_t i;
+    if ((s = PyObject_New(RowSchema, &RowSchemaType)) == NULL) {
+        return NULL;
+    }
+    s->names = NULL;
+    s->keys = NULL;
+    if ((s->encoder = encoder_new(columns_copy(e->Columns), e->Settings)) == NULL) {
+        PyErr_SetString(EncoderError, "Unable to create row schema");
+        goto error;
+    }
+    encoder_set_null(s->encoder, e->NullValue);
+    if ((s->names = PyDict_New()) == NULL || (s->keys = PyList_New(e->Columns->length)) == NULL) {
+        goto error;
+    }
+    // Columns are found by name or by title, which is the key used for
+    // rows decoded as dicts.
+    for (i=0; i<e->Columns->length; i++) {
+        column = &e->Columns->array[i];
+        key = column->Title != NULL ? column->Title : column->Name;
+        if ((index = PyLong_FromSize_t(i)) == NULL) {
+            goto error;
+        }
+        if ((column->Name != NULL && PyDict_SetItemString(s->names, column->Name, index) != 0) ||
+                PyDict_SetItemString(s->names, key, index) != 0) {
+            Py_DECREF(index);
+            goto error;
+        }
+        Py_DECREF(index);
+        if (column->Key != NULL) {
+            Py_INCREF(column->Key);
+            PyList_SET_ITEM(s->keys, i, column->Key);
+        } else {
+            PyList_SET_ITEM(s->keys, i, PyUnicode_FromString(key));
+        }
+    }
+    return (PyObject*)s;
+error:
+    Py_DECREF(s);
+    return NULL;
+}
+
+// The schema is shared by every block decoded until the columns, the
+// settings or the null value of the encoder change.
+static RowSchema* row_schema_get(TeradataEncoder *e) {
+    if (e->RowSchema == NULL) {
+        e->RowSchema = row_schema_new(e);
+    }
+    return (RowSchema*)e->RowSchema;
+}
+
+PyObject* teradata_buffer_to_lazyrows(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
+    PyObject *rows = NULL;
+    PyObject *block = NULL;
+    RowSchema *schema;
+    LazyRow *row;
+    unsigned char *start = *data;
+    unsigned char **index = NULL;
+    int i, n;
+    if (e->Columns == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return NULL;
+    }
+    Py_RETURN_ERROR(schema = row_schema_get((TeradataEncoder*)e));
+    if ((n = teradata_buffer_index_rows(e, *data, length, &index)) < 0) {
+        return NULL;
+    }
+    if ((block = PyBytes_FromStringAndSize((char*)*data, length)) == NULL ||
+            (rows = PyList_New(n)) == NULL) {
+        goto error;
+    }
+    for (i=0; i<n; i++) {
+        if ((row = PyObject_New(LazyRow, &LazyRowType)) == NULL) {
+            Py_CLEAR(rows);
+            goto error;
+        }
+        Py_INCREF(schema);
+        Py_INCREF(block);
+        row->schema = schema;
+        row->block = block;
+        // skip the length prefix so the offset is that of the indicator header
+        row->offset = (uint32_t)(index[i] - start) + sizeof(uint16_t);
+        row->offsets = NULL;
+        PyList_SET_ITEM(rows, i, (PyObject*)row);
+    }
+    *data = start + length;
+error:
+    Py_XDECREF(block);
+    free(index);
+    return rows;
+}
+
+static void RowSchema_dealloc(RowSchema *self) {
+    GiraffeColumns *columns;
+    if (self->encoder != NULL) {
+        columns = self->encoder->Columns;
+        encoder_free(self->encoder);
+        if (columns != NULL) {
+            free(columns->raw);
+            free(columns);
+        }
+    }
+    Py_XDECREF(self->names);
+    Py_XDECREF(self->keys);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+PyTypeObject RowSchemaType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_teradata.RowSchema",                          /* tp_name */
+    sizeof(RowSchema),                              /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    (destructor)RowSchema_dealloc,                  /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    0,                                              /* tp_repr */
+    0,                                              /* tp_as_number */
+    0,                                              /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                             /* tp_flags */
+    "RowSchema objects",                            /* tp_doc */
+};
+
+// Returns a pointer to the value of the column at pos. Columns up to the
+// first variable width column are at a constant offset, the offsets of
+// the remaining columns are computed once and kept with the row.
+static unsigned char* lazyrow_locate(LazyRow *self, const size_t pos) {
+    GiraffeColumns *columns = self->schema->encoder->Columns;
+    GiraffeColumn *column;
+    unsigned char *row;
+    unsigned char *data;
+    size_t i;
+    row = (unsigned char*)PyBytes_AS_STRING(self->block) + self->offset;
+    if (pos <= columns->fixed_columns) {
+        return columns_locate(columns, row, pos);
+    }
+    if (self->offsets == NULL) {
+        self->offsets = (uint32_t*)malloc((columns->length - columns->fixed_columns) * sizeof(uint32_t));
+        if (self->offsets == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        data = columns_locate(columns, row, columns->fixed_columns);
+        for (i=columns->fixed_columns; i<columns->length; i++) {
+            column = &columns->array[i];
+            self->offsets[i - columns->fixed_columns] = (uint32_t)(data - row);
+            if (indicator_is_null(row, i)) {
+                data += column->NullLength;
+            } else {
+                column_skip(&data, column);
+            }
+        }
+    }
+    return row + self->offsets[pos - columns->fixed_columns];
+}
+
+static void LazyRow_dealloc(LazyRow *self) {
+    Py_XDECREF(self->schema);
+    Py_XDECREF(self->block);
+    free(self->offsets);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static Py_ssize_t LazyRow_length(LazyRow *self) {
+    return (Py_ssize_t)self->schema->encoder->Columns->length;
+}
+
+static PyObject* LazyRow_item(LazyRow *self, Py_ssize_t i) {
+    TeradataEncoder *e = self->schema->encoder;
+    unsigned char *row;
+    unsigned char *data;
+    if (i < 0 || (size_t)i >= e->Columns->length) {
+        PyErr_SetString(PyExc_IndexError, "row index out of range");
+        return NULL;
+    }
+    row = (unsigned char*)PyBytes_AS_STRING(self->block) + self->offset;
+    if (indicator_is_null(row, i)) {
+        Py_INCREF(e->NullValue);
+        return e->NullValue;
+    }
+    Py_RETURN_ERROR(data = lazyrow_locate(self, i));
+    return teradata_item_to_pyobject(e, &data, &e->Columns->array[i]);
+}
+
+// Names are looked up exactly first and then ignoring case, the same as
+// Teradata compares column names.
+static Py_ssize_t lazyrow_find(LazyRow *self, PyObject *key) {
+    GiraffeColumns *columns = self->schema->encoder->Columns;
+    PyObject *index;
+    const char *name;
+    size_t i;
+    if ((index = PyDict_GetItem(self->schema->names, key)) != NULL) {
+        return PyLong_AsSsize_t(index);
+    }
+    if ((name = PyUnicode_AsUTF8(key)) == NULL) {
+        return -1;
+    }
+    for (i=0; i<columns->length; i++) {
+        if (columns->array[i].Name != NULL && compare_name(name, columns->array[i].Name) == 0) {
+            return (Py_ssize_t)i;
+        }
+    }
+    PyErr_SetObject(PyExc_KeyError, key);
+    return -1;
+}
+
+static PyObject* LazyRow_subscript(LazyRow *self, PyObject *key) {
+    Py_ssize_t i;
+    if (PyStr_Check(key)) {
+        if ((i = lazyrow_find(self, key)) < 0) {
+            return NULL;
+        }
+    } else {
+        if ((i = PyNumber_AsSsize_t(key, PyExc_IndexError)) == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (i < 0) {
+            i += LazyRow_length(self);
+        }
+    }
+    return LazyRow_item(self, i);
+}
+
+static PyObject* LazyRow_repr(LazyRow *self) {
+    PyObject *values;
+    PyObject *repr;
+    Py_RETURN_ERROR(values = PySequence_Tuple((PyObject*)self));
+    repr = PyObject_Repr(values);
+    Py_DECREF(values);
+    return repr;
+}
+
+static PyObject* LazyRow_keys(LazyRow *self) {
+    return PyList_GetSlice(self->schema->keys, 0, PY_SSIZE_T_MAX);
+}
+
+static PyMethodDef LazyRow_methods[] = {
+    {"keys", (PyCFunction)LazyRow_keys, METH_NOARGS, ""},
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods LazyRow_as_sequence = {
+    (lenfunc)LazyRow_length,                        /* sq_length */
+    0,                                              /* sq_concat */
+    0,                                              /* sq_repeat */
+    (ssizeargfunc)LazyRow_item,                     /* sq_item */
+};
+
+static PyMappingMethods LazyRow_as_mapping = {
+    (lenfunc)LazyRow_length,                        /* mp_length */
+    (binaryfunc)LazyRow_subscript,                  /* mp_subscript */
+};
+
+PyTypeObject LazyRowType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_teradata.LazyRow",                            /* tp_name */
+    sizeof(LazyRow),                                /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    (destructor)LazyRow_dealloc,                    /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    (reprfunc)LazyRow_repr,                         /* tp_repr */
+    0,                                              /* tp_as_number */
+    &LazyRow_as_sequence,                           /* tp_as_sequence */
+    &LazyRow_as_mapping,                            /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    0,                                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                             /* tp_flags */
+    "LazyRow objects",                              /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    0,                                              /* tp_iter */
+    0,                                              /* tp_iternext */
+    LazyRow_methods,                                /* tp_methods */
+};
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_LAZY_H
+#define __GIRAFFEZ_LAZY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include "columns.h"
+#include "encoder.h"
+
+
+// The schema shared by every lazy row decoded with the same columns and
+// settings. It owns a private encoder over a copy of the columns so rows
+// remain valid after the encoder that produced them changes.
+typedef struct {
+    PyObject_HEAD
+    TeradataEncoder *encoder;
+    PyObject        *names;
+    PyObject        *keys;
+} RowSchema;
+
+// A row that decodes its columns on access. The row references the block
+// it was received in and the offset of its indicator header within it.
+// The offsets of the columns following a variable width column are
+// computed the first time one of them is accessed.
+typedef struct {
+    PyObject_HEAD
+    RowSchema *schema;
+    PyObject  *block;
+    uint32_t  offset;
+    uint32_t  *offsets;
+} LazyRow;
+
+PyObject* teradata_buffer_to_lazyrows(const TeradataEncoder *e, unsigned char **data, const uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "pool.h"
+
+
+// Workers never hold the GIL and must not use the Python API other than
+// the thread locks.
+static void worker_main(void *arg) {
+    PoolWorker *w = (PoolWorker*)arg;
+    while (1) {
+        PyThread_acquire_lock(w->start, WAIT_LOCK);
+        if (w->task == NULL) {
+            break;
+        }
+        w->task(w->arg);
+        PyThread_release_lock(w->done);
+    }
+    PyThread_release_lock(w->done);
+}
+
+static int worker_init(PoolWorker *w) {
+    w->task = NULL;
+    w->arg = NULL;
+    if ((w->start = PyThread_allocate_lock()) == NULL) {
+        return -1;
+    }
+    if ((w->done = PyThread_allocate_lock()) == NULL) {
+        PyThread_free_lock(w->start);
+        return -1;
+    }
+    PyThread_acquire_lock(w->start, WAIT_LOCK);
+    PyThread_acquire_lock(w->done, WAIT_LOCK);
+    return 0;
+}
+
+WorkerPool* worker_pool_new(const size_t length) {
+    WorkerPool *p;
+    size_t i;
+    if ((p = (WorkerPool*)malloc(sizeof(WorkerPool))) == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    p->length = 0;
+    if ((p->workers = (PoolWorker*)malloc(length * sizeof(PoolWorker))) == NULL) {
+        free(p);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (i=0; i<length; i++) {
+        if (worker_init(&p->workers[i]) != 0) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        if (PyThread_start_new_thread(worker_main, &p->workers[i]) == PYTHREAD_INVALID_THREAD_ID) {
+            PyThread_free_lock(p->workers[i].start);
+            PyThread_free_lock(p->workers[i].done);
+            PyErr_SetString(PyExc_RuntimeError, "Unable to start decode worker thread");
+            goto error;
+        }
+        p->length++;
+    }
+    return p;
+error:
+    worker_pool_free(p);
+    return NULL;
+}
+
+void worker_pool_submit(WorkerPool *p, const size_t i, PoolTask task, void *arg) {
+    p->workers[i].task = task;
+    p->workers[i].arg = arg;
+    PyThread_release_lock(p->workers[i].start);
+}
+
+// Blocks until the task given to worker i has returned, which should be
+// called with the GIL released.
+void worker_pool_wait(WorkerPool *p, const size_t i) {
+    PyThread_acquire_lock(p->workers[i].done, WAIT_LOCK);
+}
+
+void worker_pool_free(WorkerPool *p) {
+    size_t i;
+    if (p == NULL) {
+        return;
+    }
+    for (i=0; i<p->length; i++) {
+        worker_pool_submit(p, i, NULL, NULL);
+    }
+    Py_BEGIN_ALLOW_THREADS
+    for (i=0; i<p->length; i++) {
+        worker_pool_wait(p, i);
+    }
+    Py_END_ALLOW_THREADS
+    for (i=0; i<p->length; i++) {
+        PyThread_free_lock(p->workers[i].start);
+        PyThread_free_lock(p->workers[i].done);
+    }
+    free(p->workers);
+    free(p);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_POOL_H
+#define __GIRAFFEZ_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include <pythread.h>
+
+
+typedef void (*PoolTask)(void*);
+
+// A worker is handed a task by releasing start and releases done once the
+// task has returned. Both locks are otherwise held by the pool.
+typedef struct PoolWorker {
+    PyThread_type_lock start;
+    PyThread_type_lock done;
+    PoolTask           task;
+    void               *arg;
+} PoolWorker;
+
+// A fixed set of threads that run tasks without the GIL. Tasks are given
+// to a particular worker, which the caller waits on before reusing it, so
+// results can be collected in the order the tasks were submitted.
+typedef struct WorkerPool {
+    size_t     length;
+    PoolWorker *workers;
+} WorkerPool;
+
+WorkerPool* worker_pool_new(const size_t length);
+void        worker_pool_submit(WorkerPool *p, const size_t i, PoolTask task, void *arg);
+void        worker_pool_wait(WorkerPool *p, const size_t i);
+void        worker_pool_free(WorkerPool *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "rawblock.h"
+
+
+// Buffers of detached blocks are returned here when the block is freed.
+// The pool is only used while holding the GIL.
+static char       *pool_data[RAW_BLOCK_POOL_SIZE];
+static Py_ssize_t pool_size[RAW_BLOCK_POOL_SIZE];
+static int        pool_length = 0;
+
+// Takes a buffer of at least n bytes from the pool, preferring one that
+// is already large enough, and sets size to its capacity.
+static char* pool_take(const Py_ssize_t n, Py_ssize_t *size) {
+    char *data;
+    int i;
+    if (pool_length == 0) {
+        *size = n;
+        return (char*)malloc(n > 0 ? n : 1);
+    }
+    for (i=0; i<pool_length-1; i++) {
+        if (pool_size[i] >= n) {
+            break;
+        }
+    }
+    data = pool_data[i];
+    *size = pool_size[i];
+    pool_length--;
+    pool_data[i] = pool_data[pool_length];
+    pool_size[i] = pool_size[pool_length];
+    if (*size < n) {
+        free(data);
+        *size = n;
+        return (char*)malloc(n);
+    }
+    return data;
+}
+
+static void pool_give(char *data, const Py_ssize_t size) {
+    if (pool_length == RAW_BLOCK_POOL_SIZE) {
+        free(data);
+        return;
+    }
+    pool_data[pool_length] = data;
+    pool_size[pool_length] = size;
+    pool_length++;
+}
+
+RawBlock* raw_block_new(char *data, const Py_ssize_t length) {
+    RawBlock *b;
+    if ((b = PyObject_New(RawBlock, &RawBlockType)) == NULL) {
+        return NULL;
+    }
+    b->data = data;
+    b->length = length;
+    b->size = 0;
+    b->owned = 0;
+    return b;
+}
+
+// Moves the data of a block that refers to the buffer of the export
+// operator to a buffer of its own.
+static int raw_block_own(RawBlock *b) {
+    char *data;
+    if ((data = pool_take(b->length, &b->size)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(data, b->data, b->length);
+    b->data = data;
+    b->owned = 1;
+    return 0;
+}
+
+// Copies the data of a block that refers to the buffer of the export
+// operator, unless the caller holds the only reference to it.
+int raw_block_detach(RawBlock *b) {
+    if (b->owned || Py_REFCNT(b) == 1) {
+        return 0;
+    }
+    return raw_block_own(b);
+}
+
+// Empties a block that could not be detached before the buffer of the
+// export operator is freed, so that it never refers to freed memory.
+void raw_block_empty(RawBlock *b) {
+    if (!b->owned) {
+        b->data = NULL;
+        b->length = 0;
+    }
+}
+
+static void RawBlock_dealloc(RawBlock *self) {
+    if (self->owned) {
+        pool_give(self->data, self->size);
+    }
+    self->data = NULL;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+// A view may outlive the buffer of the export operator, which cannot be
+// kept for it, so the block is copied first when it still refers to it.
+static int RawBlock_getbuffer(RawBlock *self, Py_buffer *view, int flags) {
+    if (!self->owned && raw_block_own(self) != 0) {
+        return -1;
+    }
+    return PyBuffer_FillInfo(view, (PyObject*)self, self->data, self->length, 1, flags);
+}
+
+static Py_ssize_t RawBlock_length(RawBlock *self) {
+    return self->length;
+}
+
+static PyObject* RawBlock_tobytes(RawBlock *self) {
+    return PyBytes_FromStringAndSize(self->data, self->length);
+}
+
+static PyMethodDef RawBlock_methods[] = {
+    {"tobytes", (PyCFunction)RawBlock_tobytes, METH_NOARGS, ""},
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods RawBlock_as_sequence = {
+    (lenfunc)RawBlock_length,                       /* sq_length */
+};
+
+static PyBufferProcs RawBlock_as_buffer = {
+#if PY_MAJOR_VERSION < 3
+    0,                                              /* bf_getreadbuffer */
+    0,                                              /* bf_getwritebuffer */
+    0,                                              /* bf_getsegcount */
+    0,                                              /* bf_getcharbuffer */
+#endif
+    (getbufferproc)RawBlock_getbuffer,              /* bf_getbuffer */
+    0,                                              /* bf_releasebuffer */
+};
+
+PyTypeObject RawBlockType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_teradatapt.RawBlock",                         /* tp_name */
+    sizeof(RawBlock),                               /* tp_basicsize */
+    0,                                              /* tp_itemsize */
+    (destructor)RawBlock_dealloc,                   /* tp_dealloc */
+    0,                                              /* tp_print */
+    0,                                              /* tp_getattr */
+    0,                                              /* tp_setattr */
+    0,                                              /* tp_compare */
+    0,                                              /* tp_repr */
+    0,                                              /* tp_as_number */
+    &RawBlock_as_sequence,                          /* tp_as_sequence */
+    0,                                              /* tp_as_mapping */
+    0,                                              /* tp_hash */
+    0,                                              /* tp_call */
+    0,                                              /* tp_str */
+    0,                                              /* tp_getattro */
+    0,                                              /* tp_setattro */
+    &RawBlock_as_buffer,                            /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+    "RawBlock objects",                             /* tp_doc */
+    0,                                              /* tp_traverse */
+    0,                                              /* tp_clear */
+    0,                                              /* tp_richcompare */
+    0,                                              /* tp_weaklistoffset */
+    0,                                              /* tp_iter */
+    0,                                              /* tp_iternext */
+    RawBlock_methods,                               /* tp_methods */
+};
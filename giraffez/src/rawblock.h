@@ -0,0 +1,53 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_RAWBLOCK_H
+#define __GIRAFFEZ_RAWBLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+
+
+// The number of detached block buffers kept for reuse.
+#define RAW_BLOCK_POOL_SIZE 4
+
+// A block of rows exactly as received from the server, exposed to Python
+// through the buffer protocol. A block first refers to the buffer of the
+// export operator, which is only valid until the next buffer is received,
+// so it must be detached before then. A block that is still referenced is
+// copied to a buffer from a small pool of reusable buffers, one that is
+// not is simply released. Views of the data can outlive the operator, so
+// a block is copied the same way when a view of it is first taken.
+typedef struct {
+    PyObject_HEAD
+    char       *data;
+    Py_ssize_t length;
+    Py_ssize_t size;
+    int        owned;
+} RawBlock;
+
+RawBlock* raw_block_new(char *data, const Py_ssize_t length);
+int       raw_block_detach(RawBlock *b);
+void      raw_block_empty(RawBlock *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
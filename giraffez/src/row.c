@@ -16,10 +16,13 @@
 
 
 #include "common.h"
+#include "array.h"
+#include "block.h"
 #include "buffer.h"
 #include "columns.h"
 #include "convert.h"
 #include "encoder.h"
+#include "filter.h"
 
 #include "row.h"
 
@@ -35,6 +38,37 @@ uint32_t teradata_buffer_count_rows(unsigned char *data, const uint32_t length)
     return n;
 }
 
+// Records a pointer to the length prefix of every row in the block that
+// matches the filter of the encoder, so results can be allocated once and
+// rows can be decoded independently of each other. Returns the number of
+// rows, or -1 with an exception set. The caller frees *rows.
+int teradata_buffer_index_rows(const TeradataEncoder *e, unsigned char *data, const uint32_t length,
+        unsigned char ***rows) {
+    unsigned char *start = data;
+    uint16_t row_length;
+    uint32_t n = 0;
+    if (e->Predicates != NULL && e->Filter == NULL) {
+        PyErr_SetString(EncoderError, "Row filter does not match the columns");
+        return -1;
+    }
+    *rows = (unsigned char**)malloc((teradata_buffer_count_rows(data, length) + 1) * sizeof(unsigned char*));
+    if (*rows == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    while ((data-start) < length) {
+        (*rows)[n] = data;
+        row_length = 0;
+        unpack_uint16_t(&data, &row_length);
+        // Rows are filtered on the raw bytes before any objects are built
+        if (e->Filter == NULL || filter_match(e->Filter, e->Columns, data)) {
+            n++;
+        }
+        data += row_length;
+    }
+    return (int)n;
+}
+
 PyObject* teradata_buffer_to_pybytes(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
     PyObject *result;
     result = PyTuple_New(1);
@@ -42,150 +76,1205 @@ PyObject* teradata_buffer_to_pybytes(const TeradataEncoder *e, unsigned char **d
     return result;
 }
 
-PyObject* teradata_buffer_to_pylist(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
-    PyObject *row;
-    PyObject *rows;
-    uint16_t row_length;
+// Columnar representation used by teradata_buffer_to_columns. Numbers are
+// stored as fixed-width values while everything else is stored as
+// variable-length bytes addressed by an offsets array. With
+// DECIMAL_AS_SCALED_INT, DECIMAL and NUMBER columns hold their unscaled
+// values, as int64 when the precision of the column allows it and as
+// little-endian 128-bit integers, exposed as pairs of int64, otherwise.
+enum ColumnKinds {
+    COLUMN_INT64,
+    COLUMN_INT128,
+    COLUMN_DOUBLE,
+    COLUMN_BINARY
+};
+
+static int column_kind(const uint32_t settings, const GiraffeColumn *column) {
+    int scaled_int = (settings & DECIMAL_RETURN_MASK) == DECIMAL_AS_SCALED_INT;
+    switch (column->GDType) {
+        case GD_BYTEINT:
+        case GD_SMALLINT:
+        case GD_INTEGER:
+        case GD_BIGINT:
+            return COLUMN_INT64;
+        case GD_DECIMAL:
+            if (scaled_int) {
+                return column->Length <= DECIMAL64 ? COLUMN_INT64 : COLUMN_INT128;
+            }
+            return COLUMN_DOUBLE;
+        case GD_NUMBER:
+            if (scaled_int) {
+                return column->Precision > 0 && column->Precision <= 18 ? COLUMN_INT64 : COLUMN_INT128;
+            }
+            return COLUMN_DOUBLE;
+        case GD_FLOAT:
+            return COLUMN_DOUBLE;
+        default:
+            return COLUMN_BINARY;
+    }
+}
+
+static int column_to_int128(unsigned char **data, const GiraffeColumn *column, uint64_t *hi,
+        uint64_t *lo) {
+    if (column->GDType == GD_DECIMAL) {
+        if (teradata_decimal_to_int128(data, column->Length, hi, lo) != 0) {
+            PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+            return -1;
+        }
+    } else if (teradata_number_to_int128(data, column->Scale, hi, lo) != 0) {
+        PyErr_SetString(EncoderError, "NUMBER value cannot be represented at the scale of its column");
+        return -1;
+    }
+    return 0;
+}
+
+static int column_to_int64(unsigned char **data, const GiraffeColumn *column, int64_t *q) {
+    int8_t b; int16_t h; int32_t l;
+    uint64_t hi, lo;
+    switch (column->GDType) {
+        case GD_BYTEINT:
+            unpack_int8_t(data, &b);
+            *q = b;
+            break;
+        case GD_SMALLINT:
+            unpack_int16_t(data, &h);
+            *q = h;
+            break;
+        case GD_INTEGER:
+            unpack_int32_t(data, &l);
+            *q = l;
+            break;
+        case GD_DECIMAL:
+        case GD_NUMBER:
+            if (column_to_int128(data, column, &hi, &lo) != 0) {
+                return -1;
+            }
+            if (hi != ((int64_t)lo < 0 ? ~0ULL : 0)) {
+                PyErr_SetString(EncoderError, "NUMBER value does not fit the precision of its column");
+                return -1;
+            }
+            *q = (int64_t)lo;
+            break;
+        default:
+            unpack_int64_t(data, q);
+    }
+    return 0;
+}
+
+static int column_to_double(unsigned char **data, const GiraffeColumn *column, double *d) {
+    int n;
+    char item[BUFFER_ITEM_SIZE];
+    switch (column->GDType) {
+        case GD_FLOAT:
+            unpack_float(data, d);
+            return 0;
+        case GD_DECIMAL:
+            if (teradata_decimal_to_double(data, column->Length, column->Scale, d) == 0) {
+                return 0;
+            }
+            n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item);
+            break;
+        default:
+            if (teradata_number_to_double(data, d) == 0) {
+                return 0;
+            }
+            n = teradata_number_to_cstring(data, item);
+    }
+    if (n < 0) {
+        PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+        return -1;
+    }
+    *d = PyOS_string_to_double(item, NULL, NULL);
+    if (*d == -1.0 && PyErr_Occurred()) {
+        return -1;
+    }
+    return 0;
+}
+
+static int column_to_binary(unsigned char **data, const GiraffeColumn *column, GiraffeArray *values) {
+    int n;
+    char item[BUFFER_ITEM_SIZE];
+    uint16_t H;
+    unsigned char *s;
+    switch (column->GDType) {
+        case GD_VARCHAR:
+        case GD_VARBYTE:
+            unpack_uint16_t(data, &H);
+            n = H;
+            s = *data;
+            break;
+        case GD_DATE:
+            if ((n = teradata_date_to_cstring(data, item)) < 0) {
+                PyErr_SetString(EncoderError, "Unexpected error while converting date");
+                return -1;
+            }
+            if (array_reserve(values, n) != 0) {
+                return -1;
+            }
+            array_write(values, item, n);
+            return 0;
+        default:
+            n = column->Length;
+            s = *data;
+    }
+    if (array_reserve(values, n) != 0) {
+        return -1;
+    }
+    array_write(values, s, n);
+    *data += n;
+    return 0;
+}
+
+static int column_decode(unsigned char **data, const GiraffeColumn *column, const int kind,
+        const int is_null, GiraffeArray *validity, GiraffeArray *offsets, GiraffeArray *values,
+        const uint32_t row) {
+    uint64_t *pair;
+    if (is_null) {
+        *data += column->NullLength;
+    } else {
+        bitmap_set((unsigned char*)validity->data, row);
+        switch (kind) {
+            case COLUMN_INT64:
+                if (column_to_int64(data, column, &((int64_t*)values->data)[row]) != 0) {
+                    return -1;
+                }
+                break;
+            case COLUMN_INT128:
+                pair = &((uint64_t*)values->data)[2 * row];
+                if (column_to_int128(data, column, &pair[1], &pair[0]) != 0) {
+                    return -1;
+                }
+                break;
+            case COLUMN_DOUBLE:
+                if (column_to_double(data, column, &((double*)values->data)[row]) != 0) {
+                    return -1;
+                }
+                break;
+            default:
+                if (column_to_binary(data, column, values) != 0) {
+                    return -1;
+                }
+        }
+    }
+    if (kind == COLUMN_BINARY) {
+        ((int32_t*)offsets->data)[row+1] = (int32_t)values->length;
+    }
+    return 0;
+}
+
+PyObject* teradata_buffer_to_columns(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
+    PyObject *result = NULL;
+    PyObject *item;
+    GiraffeArray **validity = NULL;
+    GiraffeArray **offsets = NULL;
+    GiraffeArray **values = NULL;
+    GiraffeColumn *column;
+    int *kinds = NULL;
     unsigned char *start = *data;
-    rows = PyList_New(0);
-    while ((*data-start) < length) {
-        row_length = 0;
-        unpack_uint16_t(data, &row_length);
-        Py_RETURN_ERROR(row = e->UnpackRowFunc(e, data, row_length));
-        PyList_Append(rows, row);
-        Py_DECREF(row);
+    unsigned char **rows = NULL;
+    unsigned char *row;
+    unsigned char *value;
+    uint16_t row_length;
+    uint32_t nrows, j;
+    size_t i, ncolumns;
+    if (e->Columns == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking columns");
+        return NULL;
     }
-    return rows;
+    ncolumns = e->Columns->length;
+    nrows = teradata_buffer_count_rows(*data, length);
+    validity = (GiraffeArray**)calloc(ncolumns, sizeof(GiraffeArray*));
+    offsets = (GiraffeArray**)calloc(ncolumns, sizeof(GiraffeArray*));
+    values = (GiraffeArray**)calloc(ncolumns, sizeof(GiraffeArray*));
+    kinds = (int*)calloc(ncolumns, sizeof(int));
+    if (validity == NULL || offsets == NULL || values == NULL || kinds == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    for (i=0; i<ncolumns; i++) {
+        column = &e->Columns->array[i];
+        if ((validity[i] = array_new("B", 1, (nrows+7)/8)) == NULL) {
+            goto error;
+        }
+        validity[i]->length = (nrows+7)/8;
+        switch ((kinds[i] = column_kind(e->Settings, column))) {
+            case COLUMN_INT64:
+                values[i] = array_new("q", sizeof(int64_t), nrows);
+                break;
+            case COLUMN_INT128:
+                values[i] = array_new("2q", 2 * sizeof(int64_t), nrows);
+                break;
+            case COLUMN_DOUBLE:
+                values[i] = array_new("d", sizeof(double), nrows);
+                break;
+            default:
+                if ((offsets[i] = array_new("i", sizeof(int32_t), nrows+1)) == NULL) {
+                    goto error;
+                }
+                offsets[i]->length = nrows+1;
+                values[i] = array_new("B", 1, nrows * column->Length);
+                continue;
+        }
+        if (values[i] == NULL) {
+            goto error;
+        }
+        values[i]->length = nrows;
+    }
+    if (columns_is_fixed(e->Columns)) {
+        // Every column sits at a constant offset so the block is decoded
+        // one column at a time, keeping writes to a single array.
+        if (nrows > 0 && (rows = (unsigned char**)malloc(nrows * sizeof(unsigned char*))) == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        for (j=0; j<nrows; j++) {
+            row_length = 0;
+            unpack_uint16_t(data, &row_length);
+            rows[j] = *data;
+            *data += row_length;
+        }
+        for (i=0; i<ncolumns; i++) {
+            column = &e->Columns->array[i];
+            for (j=0; j<nrows; j++) {
+                value = rows[j] + e->Columns->header_length + column->Offset;
+                if (column_decode(&value, column, kinds[i], indicator_is_null(rows[j], i),
+                        validity[i], offsets[i], values[i], j) != 0) {
+                    goto error;
+                }
+            }
+        }
+    } else {
+        for (j=0; j<nrows; j++) {
+            row_length = 0;
+            unpack_uint16_t(data, &row_length);
+            row = *data;
+            *data += e->Columns->header_length;
+            for (i=0; i<ncolumns; i++) {
+                if (column_decode(data, &e->Columns->array[i], kinds[i], indicator_is_null(row, i),
+                        validity[i], offsets[i], values[i], j) != 0) {
+                    goto error;
+                }
+            }
+            *data = row + row_length;
+        }
+    }
+    if ((result = PyList_New(ncolumns)) == NULL) {
+        goto error;
+    }
+    for (i=0; i<ncolumns; i++) {
+        if ((item = PyTuple_New(3)) == NULL) {
+            Py_CLEAR(result);
+            goto error;
+        }
+        PyTuple_SET_ITEM(item, 0, (PyObject*)validity[i]);
+        if (offsets[i] == NULL) {
+            Py_INCREF(Py_None);
+            PyTuple_SET_ITEM(item, 1, Py_None);
+        } else {
+            PyTuple_SET_ITEM(item, 1, (PyObject*)offsets[i]);
+        }
+        PyTuple_SET_ITEM(item, 2, (PyObject*)values[i]);
+        validity[i] = offsets[i] = values[i] = NULL;
+        PyList_SET_ITEM(result, i, item);
+    }
+error:
+    for (i=0; validity != NULL && offsets != NULL && values != NULL && i<ncolumns; i++) {
+        Py_XDECREF(validity[i]);
+        Py_XDECREF(offsets[i]);
+        Py_XDECREF(values[i]);
+    }
+    free(validity);
+    free(offsets);
+    free(values);
+    free(kinds);
+    free(rows);
+    if (result == NULL) {
+        *data = start;
+    }
+    return result;
 }
 
-PyObject* teradata_row_to_pydict(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
+// Executes a run of adjacent columns sharing an opcode, storing a new
+// reference for each column into out. Rows without any nulls take a
+// path that does not test the indicator bit of each column.
+#define DECODE_RUN(expr) \
+    out = items + op->Item; \
+    if (nulls == 0) { \
+        for (k=0; k<op->Count; k++) { \
+            column = &e->Columns->array[op->Column+k]; \
+            if ((out[k] = (expr)) == NULL) { \
+                goto error; \
+            } \
+        } \
+    } else { \
+        for (k=0; k<op->Count; k++) { \
+            column = &e->Columns->array[op->Column+k]; \
+            if (indicator_is_null(e->Columns->buffer, op->Column+k)) { \
+                *data += column->NullLength; \
+                Py_INCREF(e->NullValue); \
+                out[k] = e->NullValue; \
+                continue; \
+            } \
+            if ((out[k] = (expr)) == NULL) { \
+                goto error; \
+            } \
+        } \
+    }
+
+// Advances past a run of variable width columns left out of the
+// projection.
+static void skip_run(const TeradataEncoder *e, const DecodeOp *op, unsigned char **data, const int nulls) {
+    GiraffeColumn *column;
+    size_t k;
+    for (k=op->Column; k<op->Column+op->Count; k++) {
+        column = &e->Columns->array[k];
+        if (nulls && indicator_is_null(e->Columns->buffer, k)) {
+            *data += column->NullLength;
+        } else {
+            column_skip(data, column);
+        }
+    }
+}
+
+static PyObject* decimal_to_pyobject(unsigned char **data, const GiraffeColumn *column,
+        PyObject *(*func)(const char*, const int)) {
+    int n;
+    char item[BUFFER_ITEM_SIZE];
+    if ((n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
+        PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+        return NULL;
+    }
+    return func(item, n);
+}
+
+static PyObject* number_to_pyobject(unsigned char **data, PyObject *(*func)(const char*, const int)) {
+    int n;
+    char item[BUFFER_ITEM_SIZE];
+    if ((n = teradata_number_to_cstring(data, item)) < 0) {
+        PyErr_SetString(EncoderError, "Unexpected error while converting number");
+        return NULL;
+    }
+    return func(item, n);
+}
+
+static PyObject* decimal_to_pyfloat(unsigned char **data, const GiraffeColumn *column) {
+    double d;
+    if (teradata_decimal_to_double(data, column->Length, column->Scale, &d) == 0) {
+        return PyFloat_FromDouble(d);
+    }
+    return decimal_to_pyobject(data, column, cstring_to_pyfloat);
+}
+
+static PyObject* number_to_pyfloat(unsigned char **data) {
+    double d;
+    if (teradata_number_to_double(data, &d) == 0) {
+        return PyFloat_FromDouble(d);
+    }
+    return number_to_pyobject(data, cstring_to_pyfloat);
+}
+
+static PyObject* decimal_to_pylong(unsigned char **data, const GiraffeColumn *column) {
+    uint64_t hi, lo;
+    if (teradata_decimal_to_int128(data, column->Length, &hi, &lo) != 0) {
+        PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+        return NULL;
+    }
+    return pylong_from_int128(hi, lo);
+}
+
+static PyObject* number_to_pylong(unsigned char **data, const GiraffeColumn *column) {
+    uint64_t hi, lo;
+    if (teradata_number_to_int128(data, column->Scale, &hi, &lo) != 0) {
+        PyErr_SetString(EncoderError, "NUMBER value cannot be represented at the scale of its column");
+        return NULL;
+    }
+    return pylong_from_int128(hi, lo);
+}
+
+// Values of the columns compiled to OP_CACHED are looked up by their raw
+// bytes, the length prefix included for VARCHAR, and share the object
+// decoded the first time the value was seen.
+PyObject* teradata_cached_to_pyobject(const TeradataEncoder *e, unsigned char **data,
+        const GiraffeColumn *column, ValueCache *cache) {
+    unsigned char *start = *data;
     PyObject *item;
+    uint64_t hash = 0;
+    uint16_t length;
+    size_t n;
+    if (column->GDType == GD_VARCHAR) {
+        memcpy(&length, start, sizeof(uint16_t));
+        n = sizeof(uint16_t) + length;
+    } else {
+        n = column->Length;
+    }
+    if (n <= VALUE_CACHE_KEY_MAX && (item = value_cache_get(cache, start, n, &hash)) != NULL) {
+        *data += n;
+        Py_INCREF(item);
+        return item;
+    }
+    switch (column->GDType) {
+        case GD_CHAR:
+            if ((e->Settings & CHAR_RETURN_MASK) == CHAR_AS_TRIMMED) {
+                item = teradata_char_to_pystring_trimmed(data, column->Length, column->FormatLength);
+            } else {
+                item = teradata_char_to_pystring_f(data, column->Length, column->FormatLength);
+            }
+            break;
+        case GD_VARCHAR:
+            item = teradata_varchar_to_pystring(data);
+            break;
+        default:
+            item = e->UnpackDateFunc(data);
+    }
+    if (item != NULL && n <= VALUE_CACHE_KEY_MAX) {
+        value_cache_put(cache, start, n, hash, item);
+    }
+    return item;
+}
+
+int teradata_row_to_pyitems(const TeradataEncoder *e, unsigned char **data, PyObject **items) {
+    const DecodeOp *op;
+    const DecodeOp *end;
+    GiraffeColumn *column;
+    PyObject **out;
+    size_t k;
+    int nulls;
+    if (e->Plan == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return -1;
+    }
+    nulls = indicator_set(e->Columns, data);
+    end = e->Plan->ops + e->Plan->length;
+    for (op=e->Plan->ops; op<end; op++) {
+        switch (op->Opcode) {
+            case OP_SKIP_FIXED:
+                *data += op->Length;
+                break;
+            case OP_SKIP:
+                skip_run(e, op, data, nulls);
+                break;
+            case OP_BYTEINT:
+                DECODE_RUN(teradata_byteint_to_pylong(data));
+                break;
+            case OP_SMALLINT:
+                DECODE_RUN(teradata_smallint_to_pylong(data));
+                break;
+            case OP_INTEGER:
+                DECODE_RUN(teradata_int_to_pylong(data));
+                break;
+            case OP_BIGINT:
+                DECODE_RUN(teradata_bigint_to_pylong(data));
+                break;
+            case OP_FLOAT:
+                DECODE_RUN(teradata_float_to_pyfloat(data));
+                break;
+            case OP_DECIMAL_AS_STRING:
+                DECODE_RUN(decimal_to_pyobject(data, column, cstring_to_pystring));
+                break;
+            case OP_DECIMAL_AS_FLOAT:
+                DECODE_RUN(decimal_to_pyfloat(data, column));
+                break;
+            case OP_DECIMAL_AS_GIRAFFEZ_DECIMAL:
+                DECODE_RUN(decimal_to_pyobject(data, column, cstring_to_giraffez_decimal));
+                break;
+            case OP_DECIMAL_AS_SCALED_INT:
+                DECODE_RUN(decimal_to_pylong(data, column));
+                break;
+            case OP_NUMBER_AS_STRING:
+                DECODE_RUN(number_to_pyobject(data, cstring_to_pystring));
+                break;
+            case OP_NUMBER_AS_FLOAT:
+                DECODE_RUN(number_to_pyfloat(data));
+                break;
+            case OP_NUMBER_AS_GIRAFFEZ_DECIMAL:
+                DECODE_RUN(number_to_pyobject(data, cstring_to_giraffez_decimal));
+                break;
+            case OP_NUMBER_AS_SCALED_INT:
+                DECODE_RUN(number_to_pylong(data, column));
+                break;
+            case OP_CHAR:
+                DECODE_RUN(teradata_char_to_pystring_f(data, column->Length, column->FormatLength));
+                break;
+            case OP_CHAR_TRIMMED:
+                DECODE_RUN(teradata_char_to_pystring_trimmed(data, column->Length, column->FormatLength));
+                break;
+            case OP_VARCHAR:
+                DECODE_RUN(teradata_varchar_to_pystring(data));
+                break;
+            case OP_DATE_AS_STRING:
+                DECODE_RUN(teradata_date_to_pystring(data));
+                break;
+            case OP_DATE_AS_GIRAFFE_TYPES:
+                DECODE_RUN(teradata_date_to_giraffez_date(data));
+                break;
+            case OP_TIME_AS_STRING:
+            case OP_TIMESTAMP_AS_STRING:
+                DECODE_RUN(teradata_char_to_pystring(data, column->Length));
+                break;
+            case OP_TIME_AS_GIRAFFE_TYPES:
+                DECODE_RUN(teradata_time_to_giraffez_time(data, column->Length));
+                break;
+            case OP_TIMESTAMP_AS_GIRAFFE_TYPES:
+                DECODE_RUN(teradata_ts_to_giraffez_ts(data, column->Length));
+                break;
+            case OP_BYTE:
+                DECODE_RUN(teradata_byte_to_pybytes(data, column->Length));
+                break;
+            case OP_VARBYTE:
+                DECODE_RUN(teradata_varbyte_to_pybytes(data));
+                break;
+            case OP_CACHED:
+                DECODE_RUN(teradata_cached_to_pyobject(e, data, column, e->Plan->caches[op->Column+k]));
+                break;
+            default:
+                DECODE_RUN(teradata_char_to_pystring(data, column->Length));
+        }
+    }
+    return 0;
+error:
+    for (k=0; k<e->Plan->width; k++) {
+        Py_CLEAR(items[k]);
+    }
+    return -1;
+}
+
+// Stores a new reference to each decoded column of a row into items, taking
+// the row from the wire (row_items) or from a block decoded ahead of time
+// (block_items). Returns -1 with an exception set and no references held.
+typedef int (*RowItemsFunc)(const TeradataEncoder*, void*, PyObject**);
+
+typedef struct BlockRow {
+    const DecodedBlock *block;
+    size_t             row;
+} BlockRow;
+
+static int row_items(const TeradataEncoder *e, void *src, PyObject **items) {
+    return teradata_row_to_pyitems(e, (unsigned char**)src, items);
+}
+
+static int block_items(const TeradataEncoder *e, void *src, PyObject **items) {
+    return decoded_block_items(e, ((BlockRow*)src)->block, ((BlockRow*)src)->row, items);
+}
+
+static PyObject* pydict_from_items(const TeradataEncoder *e, RowItemsFunc fill, void *src) {
     PyObject *row;
+    PyObject **items;
     GiraffeColumn *column;
     size_t i;
-    row = PyDict_New();
-    indicator_set(e->Columns, data);
-    for (i=0; i<e->Columns->length; i++) {
-        column = &e->Columns->array[i];
-        if (indicator_read(e->Columns->buffer, i)) {
-            *data += column->NullLength;
-            PyDict_SetItemString(row, column->Title, e->NullValue);
-            continue;
+    if (e->Plan == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return NULL;
+    }
+    Py_RETURN_ERROR(row = PyDict_NewPresized(e->Plan->width));
+    if (fill(e, src, e->Plan->items) != 0) {
+        Py_DECREF(row);
+        return NULL;
+    }
+    items = e->Plan->items;
+    for (i=0; i<e->Plan->width; i++) {
+        column = &e->Columns->array[e->Plan->columns[i]];
+        if ((column->Key != NULL ? PyDict_SetItem(row, column->Key, items[i]) :
+                PyDict_SetItemString(row, column->Title, items[i])) != 0) {
+            for (; i<e->Plan->width; i++) {
+                Py_CLEAR(items[i]);
+            }
+            Py_DECREF(row);
+            return NULL;
         }
-        Py_RETURN_ERROR(item = e->UnpackItemFunc(e, data, column));
-        PyDict_SetItemString(row, column->Title, item);
-        Py_DECREF(item);
+        Py_CLEAR(items[i]);
     }
     return row;
 }
 
-PyObject* teradata_row_to_pytuple(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
-    PyObject *item;
+static PyObject* pytuple_from_items(const TeradataEncoder *e, RowItemsFunc fill, void *src) {
     PyObject *row;
+    if (e->Plan == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return NULL;
+    }
+    Py_RETURN_ERROR(row = PyTuple_New(e->Plan->width));
+    // The tuple items are filled in place and are released along with the
+    // tuple if decoding fails.
+    if (fill(e, src, PySequence_Fast_ITEMS(row)) != 0) {
+        Py_DECREF(row);
+        return NULL;
+    }
+    return row;
+}
+
+PyObject* teradata_row_to_pydict(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
+    return pydict_from_items(e, row_items, data);
+}
+
+PyObject* teradata_row_to_pytuple(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
+    return pytuple_from_items(e, row_items, data);
+}
+
+// Builds a struct sequence type with a field for each decoded column, named
+// by its title. The member definitions refer to the UTF-8 of the interned
+// column keys, which are kept alive by the _fields attribute of the type.
+static PyObject* row_type_new(const TeradataEncoder *e) {
+#if PY_MAJOR_VERSION >= 3
+    PyStructSequence_Desc desc;
+    PyStructSequence_Field *fields = NULL;
+    PyObject *names = NULL;
+    PyObject *type = NULL;
     GiraffeColumn *column;
     size_t i;
-    row = PyTuple_New(e->Columns->length);
-    indicator_set(e->Columns, data);
-    for (i=0; i<e->Columns->length; i++) {
-        column = &e->Columns->array[i];
-        if (indicator_read(e->Columns->buffer, i)) {
-            *data += column->NullLength;
-            Py_INCREF(e->NullValue);
-            PyTuple_SetItem(row, i, e->NullValue);
-            continue;
+    if ((fields = (PyStructSequence_Field*)calloc(e->Plan->width+1, sizeof(PyStructSequence_Field))) == NULL) {
+        return PyErr_NoMemory();
+    }
+    if ((names = PyTuple_New(e->Plan->width)) == NULL) {
+        goto error;
+    }
+    for (i=0; i<e->Plan->width; i++) {
+        column = &e->Columns->array[e->Plan->columns[i]];
+        if (column->Key == NULL) {
+            PyErr_Format(EncoderError, "Column '%s' cannot be used as a field name", column->Title);
+            goto error;
+        }
+        Py_INCREF(column->Key);
+        PyTuple_SET_ITEM(names, i, column->Key);
+        if ((fields[i].name = PyUnicode_AsUTF8(column->Key)) == NULL) {
+            goto error;
         }
-        Py_RETURN_ERROR(item = e->UnpackItemFunc(e, data, column));
-        PyTuple_SetItem(row, i, item);
+        fields[i].doc = NULL;
+    }
+    desc.name = "giraffez.Row";
+    desc.doc = NULL;
+    desc.fields = fields;
+    desc.n_in_sequence = (int)e->Plan->width;
+    if ((type = (PyObject*)PyStructSequence_NewType(&desc)) == NULL) {
+        goto error;
+    }
+    if (PyObject_SetAttrString(type, "_fields", names) != 0) {
+        Py_CLEAR(type);
+    }
+error:
+    Py_XDECREF(names);
+    free(fields);
+    return type;
+#else
+    PyErr_SetString(EncoderError, "ROW_ENCODING_NAMEDTUPLE requires Python 3");
+    return NULL;
+#endif
+}
+
+// The row type is built for the first row decoded after the columns, the
+// settings or the projection change, so every statement has its own.
+static PyObject* pynamedtuple_from_items(const TeradataEncoder *e, RowItemsFunc fill, void *src) {
+    PyObject *row;
+    if (e->Plan == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return NULL;
+    }
+    if (e->RowType == NULL) {
+        Py_RETURN_ERROR(((TeradataEncoder*)e)->RowType = row_type_new(e));
+    }
+    Py_RETURN_ERROR(row = PyStructSequence_New((PyTypeObject*)e->RowType));
+    if (fill(e, src, PySequence_Fast_ITEMS(row)) != 0) {
+        Py_DECREF(row);
+        return NULL;
     }
     return row;
 }
 
+PyObject* teradata_row_to_pynamedtuple(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
+    return pynamedtuple_from_items(e, row_items, data);
+}
+
+typedef PyObject* (*RowBuildFunc)(const TeradataEncoder*, RowItemsFunc, void*);
+
+// Rows built from the decoded columns of the plan are decoded in two
+// phases. The values of every row of a block are first parsed into a
+// DecodedBlock with the GIL released, so the fetch of the next block and
+// other Python threads can run during the conversions, and the objects
+// are then created from it. Other row encodings are decoded row by row.
+static RowBuildFunc row_builder(const TeradataEncoder *e) {
+    if (e->Plan == NULL) {
+        return NULL;
+    }
+    if (e->UnpackRowFunc == teradata_row_to_pytuple) {
+        return pytuple_from_items;
+    } else if (e->UnpackRowFunc == teradata_row_to_pydict) {
+        return pydict_from_items;
+    } else if (e->UnpackRowFunc == teradata_row_to_pynamedtuple) {
+        return pynamedtuple_from_items;
+    }
+    return NULL;
+}
+
+int teradata_buffer_decodable(const TeradataEncoder *e) {
+    return e->UnpackRowsFunc == teradata_buffer_to_pylist && row_builder(e) != NULL;
+}
+
+// Creates the rows of each of the blocks, in order, in a single list.
+PyObject* teradata_blocks_to_pylist(const TeradataEncoder *e, DecodedBlock **blocks, const size_t n) {
+    RowBuildFunc build;
+    PyObject *row;
+    PyObject *rows;
+    BlockRow src;
+    Py_ssize_t count = 0;
+    size_t i;
+    if ((build = row_builder(e)) == NULL) {
+        PyErr_SetString(EncoderError, "Row encoding cannot be decoded by block");
+        return NULL;
+    }
+    for (i=0; i<n; i++) {
+        count += blocks[i]->rows;
+    }
+    Py_RETURN_ERROR(rows = PyList_New(count));
+    count = 0;
+    for (i=0; i<n; i++) {
+        src.block = blocks[i];
+        for (src.row=0; src.row<blocks[i]->rows; src.row++) {
+            if ((row = build(e, block_items, &src)) == NULL) {
+                Py_DECREF(rows);
+                return NULL;
+            }
+            PyList_SET_ITEM(rows, count++, row);
+        }
+    }
+    return rows;
+}
+
+PyObject* teradata_buffer_to_pylist(const TeradataEncoder *e, unsigned char **data, const uint32_t length) {
+    PyObject *row;
+    PyObject *rows = NULL;
+    DecodedBlock *block = NULL;
+    uint16_t row_length;
+    unsigned char *start = *data;
+    unsigned char **index;
+    int i, n, status;
+    if ((n = teradata_buffer_index_rows(e, *data, length, &index)) < 0) {
+        return NULL;
+    }
+    if (row_builder(e) != NULL) {
+        if ((block = decoded_block_new(n, e->Plan->width)) == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        encoder_hold(e);
+        Py_BEGIN_ALLOW_THREADS
+        status = decoded_block_fill(block, e, index);
+        Py_END_ALLOW_THREADS
+        encoder_release(e);
+        if (status != DECODE_OK) {
+            decoded_block_set_error(status);
+            goto error;
+        }
+        if ((rows = teradata_blocks_to_pylist(e, &block, 1)) == NULL) {
+            goto error;
+        }
+    } else {
+        if ((rows = PyList_New(n)) == NULL) {
+            goto error;
+        }
+        for (i=0; i<n; i++) {
+            *data = index[i];
+            row_length = 0;
+            unpack_uint16_t(data, &row_length);
+            if ((row = e->UnpackRowFunc(e, data, row_length)) == NULL) {
+                Py_CLEAR(rows);
+                goto error;
+            }
+            PyList_SET_ITEM(rows, i, row);
+        }
+    }
+    *data = start + length;
+error:
+    decoded_block_free(block);
+    free(index);
+    return rows;
+}
+
 PyObject* teradata_row_to_pybytes(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
     PyObject *s = PyBytes_FromStringAndSize((char*)*data, length);
     *data += length;
     return s;
 }
 
-PyObject* teradata_row_to_pystring(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
-    PyObject *row;
+// Returns 1 when the n bytes at s contain the delimiter, a double quote or
+// a line break. Only the first byte of the delimiter is searched for, with
+// the rest of it compared where that byte is found.
+static int text_needs_quotes(const TeradataEncoder *e, const char *s, const size_t n) {
+    const char delimiter = e->DelimiterStrLen > 0 ? e->DelimiterStr[0] : '"';
+    size_t i = 0;
+    while ((i += find_any_of4(s + i, n - i, '"', '\r', '\n', delimiter)) < n) {
+        if (s[i] != delimiter || (n - i >= e->DelimiterStrLen &&
+                memcmp(s + i, e->DelimiterStr, e->DelimiterStrLen) == 0)) {
+            return 1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+// Encloses the value written to out from start in double quotes when it
+// needs them, doubling the double quotes within it. Values that do not are
+// left as they were written.
+static int quote_text(const TeradataEncoder *e, buffer_t *out, const size_t start) {
+    char *s = out->data + start;
+    size_t n = out->length - start;
+    size_t i, j, quotes = 0;
+    if (!text_needs_quotes(e, s, n)) {
+        return 0;
+    }
+    for (i=0; i<n; i++) {
+        quotes += s[i] == '"';
+    }
+    if (buffer_reserve(out, quotes + 2) != 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    s = out->data + start;
+    // The value is moved in place from the end, so each byte is read
+    // before it is overwritten.
+    j = n + quotes + 1;
+    s[j--] = '"';
+    for (i=n; i-->0;) {
+        s[j--] = s[i];
+        if (s[i] == '"') {
+            s[j--] = '"';
+        }
+    }
+    s[0] = '"';
+    out->length += quotes + 2;
+    out->pos += quotes + 2;
+    return 0;
+}
+
+// Appends the text of a row, its values separated by the delimiter, to out.
+// The text of a row is expected to fit in TD_ROW_MAX_SIZE. Values are
+// quoted as needed when the encoder has quoting set.
+int teradata_row_to_text(const TeradataEncoder *e, unsigned char **data, buffer_t *out) {
     GiraffeColumn *column;
-    size_t i;
+    const DecodeOp *op;
+    const DecodeOp *end;
+    size_t i, k, start;
     int n;
     char item[BUFFER_ITEM_SIZE];
     int8_t b; int16_t h; int32_t l; int64_t q; double d; uint16_t H;
-    indicator_set(e->Columns, data);
+    int nulls;
+    if (e->Plan == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return -1;
+    }
+    nulls = indicator_set(e->Columns, data);
+    end = e->Plan->ops + e->Plan->length;
+    i = 0;
+    for (op=e->Plan->ops; op<end; op++) {
+        if (op->Opcode == OP_SKIP_FIXED) {
+            *data += op->Length;
+            continue;
+        }
+        if (op->Opcode == OP_SKIP) {
+            skip_run(e, op, data, nulls);
+            continue;
+        }
+        for (k=op->Column; k<op->Column+op->Count; k++) {
+            column = &e->Columns->array[k];
+            // Values can be longer as text than in the row, so room is made
+            // for each one before it is written
+            if (buffer_reserve(out, e->DelimiterStrLen + e->NullValueStrLen + column->Length
+                    + BUFFER_ITEM_SIZE) != 0) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            if (i++ > 0) {
+                buffer_write(out, e->DelimiterStr, e->DelimiterStrLen);
+            }
+            if (nulls && indicator_is_null(e->Columns->buffer, k)) {
+                *data += column->NullLength;
+                buffer_write(out, e->NullValueStr, e->NullValueStrLen);
+                continue;
+            }
+            start = out->length;
+            switch (column->GDType) {
+                case GD_BYTEINT:
+                    unpack_int8_t(data, &b);
+                    buffer_write_int64(out, b);
+                    break;
+                case GD_SMALLINT:
+                    unpack_int16_t(data, &h);
+                    buffer_write_int64(out, h);
+                    break;
+                case GD_INTEGER:
+                    unpack_int32_t(data, &l);
+                    buffer_write_int64(out, l);
+                    break;
+                case GD_BIGINT:
+                    unpack_int64_t(data, &q);
+                    buffer_write_int64(out, q);
+                    break;
+                case GD_FLOAT:
+                    unpack_float(data, &d);
+                    buffer_write_double(out, d, 0);
+                    break;
+                case GD_DECIMAL:
+                    if ((n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+                        return -1;
+                    }
+                    buffer_write(out, item, n);
+                    break;
+                case GD_CHAR:
+                    if ((e->Settings & CHAR_RETURN_MASK) == CHAR_AS_TRIMMED) {
+                        buffer_write(out, (char*)*data,
+                            teradata_char_length(*data, column->Length, column->FormatLength, 1));
+                    } else {
+                        buffer_write(out, (char*)*data, column->Length);
+                    }
+                    *data += column->Length;
+                    break;
+                case GD_VARCHAR:
+                    unpack_uint16_t(data, &H);
+                    buffer_write(out, (char*)*data, H);
+                    *data += H;
+                    break;
+                case GD_DATE:
+                    if ((n = teradata_date_to_cstring(data, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting date");
+                        return -1;
+                    }
+                    buffer_write(out, item, n);
+                    break;
+                case GD_NUMBER:
+                    if ((n = teradata_number_to_cstring(data, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting number");
+                        return -1;
+                    }
+                    buffer_write(out, item, n);
+                    break;
+                default:
+                    buffer_write(out, (char*)*data, column->Length);
+                    *data += column->Length;
+            }
+            if (e->Quoting && quote_text(e, out, start) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+PyObject* teradata_row_to_pystring(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
     buffer_reset(e->buffer, 0);
-    for (i=0; i<e->Columns->length; i++) {
-        column = &e->Columns->array[i];
-        if (indicator_read(e->Columns->buffer, i)) {
-            *data += column->NullLength;
-            buffer_write(e->buffer, e->NullValueStr, e->NullValueStrLen);
-            if (i != e->Columns->length-1) {
-                buffer_write(e->buffer, e->DelimiterStr, e->DelimiterStrLen);
+    if (teradata_row_to_text(e, data, e->buffer) != 0) {
+        return NULL;
+    }
+    return utf8_to_pystring(e->buffer->data, e->buffer->length);
+}
+
+static void json_write_string(buffer_t *out, const char *s, const size_t n) {
+    out->data[out->pos++] = '"';
+    out->pos += json_escape(out->data + out->pos, s, n);
+    out->data[out->pos++] = '"';
+    out->length = out->pos;
+}
+
+static void json_write_hex(buffer_t *out, const unsigned char *s, const size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    size_t i;
+    out->data[out->pos++] = '"';
+    for (i=0; i<n; i++) {
+        out->data[out->pos++] = hex[s[i] >> 4];
+        out->data[out->pos++] = hex[s[i] & 0xf];
+    }
+    out->data[out->pos++] = '"';
+    out->length = out->pos;
+}
+
+// Floats are written the same as json.dumps writes them, which includes
+// the non-standard NaN and Infinity.
+static void json_write_double(buffer_t *out, const double d) {
+    if (Py_IS_NAN(d)) {
+        buffer_write(out, "NaN", 3);
+    } else if (Py_IS_INFINITY(d)) {
+        if (d > 0) {
+            buffer_write(out, "Infinity", 8);
+        } else {
+            buffer_write(out, "-Infinity", 9);
+        }
+    } else {
+        buffer_write_double(out, d, 1);
+    }
+}
+
+static int json_write_decimal(const TeradataEncoder *e, buffer_t *out, char *item, const int n) {
+    double d;
+    switch (e->Settings & DECIMAL_RETURN_MASK) {
+        case DECIMAL_AS_STRING:
+            json_write_string(out, item, n);
+            return 0;
+        case DECIMAL_AS_GIRAFFEZ_DECIMAL:
+            buffer_write(out, item, n);
+            return 0;
+        default:
+            d = PyOS_string_to_double(item, NULL, NULL);
+            if (d == -1.0 && PyErr_Occurred()) {
+                return -1;
             }
+            json_write_double(out, d);
+            return 0;
+    }
+}
+
+// Appends a row as a JSON object to out, in the same format as json.dumps
+// with ensure_ascii=False writes the dict of the row. The object keys are
+// escaped once, when the decode plan is compiled. Dates and times are
+// written as strings and bytes as hex strings.
+int teradata_row_to_json(const TeradataEncoder *e, unsigned char **data, buffer_t *out) {
+    GiraffeColumn *column;
+    const DecodePlan *plan = e->Plan;
+    const DecodeOp *op;
+    const DecodeOp *end;
+    size_t i, k, n;
+    int m;
+    char item[BUFFER_ITEM_SIZE];
+    int8_t b; int16_t h; int32_t l; int64_t q; double d; uint16_t H;
+    uint64_t hi, lo;
+    int nulls;
+    int as_float = (e->Settings & DECIMAL_RETURN_MASK) == DECIMAL_AS_FLOAT;
+    int as_scaled_int = (e->Settings & DECIMAL_RETURN_MASK) == DECIMAL_AS_SCALED_INT;
+    if (plan == NULL || plan->keys == NULL) {
+        PyErr_SetString(EncoderError, "Columns must be set before unpacking rows");
+        return -1;
+    }
+    nulls = indicator_set(e->Columns, data);
+    end = plan->ops + plan->length;
+    i = 0;
+    for (op=plan->ops; op<end; op++) {
+        if (op->Opcode == OP_SKIP_FIXED) {
+            *data += op->Length;
             continue;
         }
-        switch (column->GDType) {
-            case GD_BYTEINT:
-                unpack_int8_t(data, &b);
-                buffer_writef(e->buffer, "%d", b);
-                break;
-            case GD_SMALLINT:
-                unpack_int16_t(data, &h);
-                buffer_writef(e->buffer, "%d", h);
-                break;
-            case GD_INTEGER:
-                unpack_int32_t(data, &l);
-                buffer_writef(e->buffer, "%d", l);
-                break;
-            case GD_BIGINT:
-                unpack_int64_t(data, &q);
-                buffer_writef(e->buffer, "%lld", q);
-                break;
-            case GD_FLOAT:
-                unpack_float(data, &d);
-                buffer_writef(e->buffer, "%.16g", d);
-                break;
-            case GD_DECIMAL:
-                if ((n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
-                    PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
-                    return NULL;
-                }
-                buffer_write(e->buffer, item, n);
-                break;
-            case GD_CHAR:
-                buffer_write(e->buffer, (char*)*data, column->Length);
-                *data += column->Length;
-                break;
-            case GD_VARCHAR:
-                unpack_uint16_t(data, &H);
-                buffer_write(e->buffer, (char*)*data, H);
-                *data += H;
-                break;
-            case GD_DATE:
-                if ((n = teradata_date_to_cstring(data, item)) < 0) {
-                    PyErr_SetString(EncoderError, "Unexpected error while converting date");
-                    return NULL;
-                }
-                buffer_write(e->buffer, item, n);
-                break;
-            case GD_NUMBER:
-                if ((n = teradata_number_to_cstring(data, item)) < 0) {
-                    PyErr_SetString(EncoderError, "Unexpected error while converting number");
-                    return NULL;
-                }
-                buffer_write(e->buffer, item, n);
-                break;
-            default:
-                buffer_write(e->buffer, (char*)*data, column->Length);
-                *data += column->Length;
+        if (op->Opcode == OP_SKIP) {
+            skip_run(e, op, data, nulls);
+            continue;
         }
-        if (i != e->Columns->length-1) {
-            buffer_write(e->buffer, e->DelimiterStr, e->DelimiterStrLen);
+        for (k=op->Column; k<op->Column+op->Count; k++, i++) {
+            column = &e->Columns->array[k];
+            n = plan->key_offsets[i+1] - plan->key_offsets[i];
+            if (buffer_reserve(out, n + column->Length * 6 + BUFFER_ITEM_SIZE + 2) != 0) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            buffer_write(out, plan->keys + plan->key_offsets[i], (int)n);
+            if (nulls && indicator_is_null(e->Columns->buffer, k)) {
+                *data += column->NullLength;
+                buffer_write(out, "null", 4);
+                continue;
+            }
+            switch (column->GDType) {
+                case GD_BYTEINT:
+                    unpack_int8_t(data, &b);
+                    buffer_write_int64(out, b);
+                    break;
+                case GD_SMALLINT:
+                    unpack_int16_t(data, &h);
+                    buffer_write_int64(out, h);
+                    break;
+                case GD_INTEGER:
+                    unpack_int32_t(data, &l);
+                    buffer_write_int64(out, l);
+                    break;
+                case GD_BIGINT:
+                    unpack_int64_t(data, &q);
+                    buffer_write_int64(out, q);
+                    break;
+                case GD_FLOAT:
+                    unpack_float(data, &d);
+                    json_write_double(out, d);
+                    break;
+                case GD_DECIMAL:
+                    if (as_scaled_int) {
+                        if (teradata_decimal_to_int128(data, column->Length, &hi, &lo) != 0) {
+                            PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+                            return -1;
+                        }
+                        buffer_write_int128(out, hi, lo);
+                        break;
+                    }
+                    if (as_float && teradata_decimal_to_double(data, column->Length, column->Scale, &d) == 0) {
+                        json_write_double(out, d);
+                        break;
+                    }
+                    if ((m = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting decimal");
+                        return -1;
+                    }
+                    if (json_write_decimal(e, out, item, m) != 0) {
+                        return -1;
+                    }
+                    break;
+                case GD_NUMBER:
+                    if (as_scaled_int) {
+                        if (teradata_number_to_int128(data, column->Scale, &hi, &lo) != 0) {
+                            PyErr_SetString(EncoderError,
+                                "NUMBER value cannot be represented at the scale of its column");
+                            return -1;
+                        }
+                        buffer_write_int128(out, hi, lo);
+                        break;
+                    }
+                    if (as_float && teradata_number_to_double(data, &d) == 0) {
+                        json_write_double(out, d);
+                        break;
+                    }
+                    if ((m = teradata_number_to_cstring(data, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting number");
+                        return -1;
+                    }
+                    if (json_write_decimal(e, out, item, m) != 0) {
+                        return -1;
+                    }
+                    break;
+                case GD_CHAR:
+                    json_write_string(out, (char*)*data, teradata_char_length(*data, column->Length,
+                        column->FormatLength, (e->Settings & CHAR_RETURN_MASK) == CHAR_AS_TRIMMED));
+                    *data += column->Length;
+                    break;
+                case GD_VARCHAR:
+                    unpack_uint16_t(data, &H);
+                    json_write_string(out, (char*)*data, H);
+                    *data += H;
+                    break;
+                case GD_DATE:
+                    if ((m = teradata_date_to_cstring(data, item)) < 0) {
+                        PyErr_SetString(EncoderError, "Unexpected error while converting date");
+                        return -1;
+                    }
+                    json_write_string(out, item, m);
+                    break;
+                case GD_BYTE:
+                    json_write_hex(out, *data, column->Length);
+                    *data += column->Length;
+                    break;
+                case GD_VARBYTE:
+                    unpack_uint16_t(data, &H);
+                    json_write_hex(out, *data, H);
+                    *data += H;
+                    break;
+                default:
+                    json_write_string(out, (char*)*data, column->Length);
+                    *data += column->Length;
+            }
         }
     }
-    Py_RETURN_ERROR(row = PyUnicode_FromStringAndSize(e->buffer->data, e->buffer->length));
-    return row;
+    if (i == 0) {
+        buffer_write(out, "{", 1);
+    }
+    buffer_write(out, "}", 1);
+    return 0;
+}
+
+PyObject* teradata_row_to_pyjson(const TeradataEncoder *e, unsigned char **data, const uint16_t length) {
+    buffer_reset(e->buffer, 0);
+    if (teradata_row_to_json(e, data, e->buffer) != 0) {
+        return NULL;
+    }
+    return utf8_to_pystring(e->buffer->data, e->buffer->length);
 }
 
 PyObject* teradata_item_to_pyobject(const TeradataEncoder *e, unsigned char **data,
@@ -205,11 +1294,20 @@ PyObject* teradata_item_to_pyobject(const TeradataEncoder *e, unsigned char **da
         case GD_FLOAT:
             return teradata_float_to_pyfloat(data);
         case GD_DECIMAL:
+            if (e->UnpackDecimalFunc == cstring_to_pyfloat) {
+                return decimal_to_pyfloat(data, column);
+            }
+            if (e->UnpackDecimalFunc == cstring_to_pylong) {
+                return decimal_to_pylong(data, column);
+            }
             if ((n = teradata_decimal_to_cstring(data, column->Length, column->Scale, item)) < 0) {
                 return NULL;
             }
             return e->UnpackDecimalFunc(item, n);
         case GD_CHAR:
+            if ((e->Settings & CHAR_RETURN_MASK) == CHAR_AS_TRIMMED) {
+                return teradata_char_to_pystring_trimmed(data, column->Length, column->FormatLength);
+            }
             return teradata_char_to_pystring_f(data, column->Length, column->FormatLength);
         case GD_VARCHAR:
             return teradata_varchar_to_pystring(data);
@@ -220,6 +1318,12 @@ PyObject* teradata_item_to_pyobject(const TeradataEncoder *e, unsigned char **da
         case GD_TIMESTAMP:
             return e->UnpackTimestampFunc(data, column->Length);
         case GD_NUMBER:
+            if (e->UnpackDecimalFunc == cstring_to_pyfloat) {
+                return number_to_pyfloat(data);
+            }
+            if (e->UnpackDecimalFunc == cstring_to_pylong) {
+                return number_to_pylong(data, column);
+            }
             if ((n = teradata_number_to_cstring(data, item)) < 0) {
                 return NULL;
             }
@@ -24,6 +24,7 @@ extern "C" {
 #include "common.h"
 #include "columns.h"
 #include "encoder.h"
+#include "block.h"
 
 
 // pack
@@ -40,16 +41,29 @@ PyObject* teradata_item_from_pyobject(const TeradataEncoder *e, const GiraffeCol
 
 // unpack
 uint32_t  teradata_buffer_count_rows(unsigned char *data, const uint32_t length);
+int       teradata_buffer_index_rows(const TeradataEncoder *e, unsigned char *data, const uint32_t length,
+    unsigned char ***rows);
+PyObject* teradata_blocks_to_pylist(const TeradataEncoder *e, DecodedBlock **blocks, const size_t n);
+int       teradata_buffer_decodable(const TeradataEncoder *e);
+PyObject* teradata_buffer_to_columns(const TeradataEncoder *e, unsigned char **data, const uint32_t length);
 PyObject* teradata_buffer_to_pybytes(const TeradataEncoder *e, unsigned char **data, const uint32_t length);
 PyObject* teradata_buffer_to_pylist(const TeradataEncoder *e, unsigned char **data, const uint32_t length);
 
+int       teradata_row_to_pyitems(const TeradataEncoder *e, unsigned char **data, PyObject **items);
 PyObject* teradata_row_to_pybytes(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
 PyObject* teradata_row_to_pydict(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
 PyObject* teradata_row_to_pystring(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
+int       teradata_row_to_text(const TeradataEncoder *e, unsigned char **data, buffer_t *out);
+PyObject* teradata_row_to_pyjson(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
+int       teradata_row_to_json(const TeradataEncoder *e, unsigned char **data, buffer_t *out);
 PyObject* teradata_row_to_pytuple(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
 
+PyObject* teradata_row_to_pynamedtuple(const TeradataEncoder *e, unsigned char **data, const uint16_t length);
+
 PyObject* teradata_item_to_pyobject(const TeradataEncoder *e, unsigned char **data,
     const GiraffeColumn *column);
+PyObject* teradata_cached_to_pyobject(const TeradataEncoder *e, unsigned char **data,
+    const GiraffeColumn *column, ValueCache *cache);
 PyObject* teradata_item_from_pystring(const TeradataEncoder *e, const GiraffeColumn *column,
     PyObject *item, unsigned char **data, uint16_t *length);
 
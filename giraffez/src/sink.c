@@ -0,0 +1,124 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "buffer.h"
+#include "encoder.h"
+#include "row.h"
+
+#if defined(WIN32) || defined(WIN64)
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+#include <errno.h>
+
+#include "sink.h"
+
+
+TextSink* text_sink_new(const int fd) {
+    TextSink *s;
+    if ((s = (TextSink*)malloc(sizeof(TextSink))) == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    s->fd = fd;
+    s->written = 0;
+    // Room is kept for a full row past the size of the sink so rows are
+    // formatted in place and the buffer is written once it is exceeded.
+    // Rows that are longer as text grow the buffer as they are formatted.
+    if ((s->buffer = buffer_new(TEXT_SINK_SIZE + TD_ROW_MAX_SIZE + 1)) == NULL || s->buffer->data == NULL) {
+        text_sink_free(s);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return s;
+}
+
+// Writes out the buffered text with the GIL released, retrying partial
+// and interrupted writes.
+int text_sink_flush(TextSink *s) {
+    char *data = s->buffer->data;
+    size_t length = s->buffer->length;
+    int n = 0;
+    Py_BEGIN_ALLOW_THREADS
+    while (length > 0) {
+        if ((n = (int)write(s->fd, data, (unsigned int)length)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        data += n;
+        length -= n;
+    }
+    Py_END_ALLOW_THREADS
+    s->written += s->buffer->length - length;
+    buffer_reset(s->buffer, 0);
+    if (n < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+    return 0;
+}
+
+// Formats the rows of a buffer received from the server and returns the
+// number of rows, after filtering. Rows are written as JSON objects when
+// the encoder returns JSON and as delimited text otherwise.
+int text_sink_rows(TextSink *s, const TeradataEncoder *e, unsigned char *data, const uint32_t length) {
+    unsigned char **index;
+    int (*format)(const TeradataEncoder*, unsigned char**, buffer_t*);
+    int i, n;
+    if ((e->Settings & ROW_RETURN_MASK) == ROW_ENCODING_JSON) {
+        format = teradata_row_to_json;
+    } else {
+        format = teradata_row_to_text;
+    }
+    if ((n = teradata_buffer_index_rows(e, data, length, &index)) < 0) {
+        return -1;
+    }
+    for (i=0; i<n; i++) {
+        data = index[i] + sizeof(uint16_t);
+        if (format(e, &data, s->buffer) != 0) {
+            goto error;
+        }
+        if (buffer_reserve(s->buffer, 1) != 0) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        buffer_write(s->buffer, "\n", 1);
+        if (s->buffer->length >= TEXT_SINK_SIZE && text_sink_flush(s) != 0) {
+            goto error;
+        }
+    }
+    free(index);
+    return n;
+error:
+    free(index);
+    return -1;
+}
+
+void text_sink_free(TextSink *s) {
+    if (s == NULL) {
+        return;
+    }
+    if (s->buffer != NULL) {
+        free(s->buffer->data);
+        free(s->buffer);
+    }
+    free(s);
+}
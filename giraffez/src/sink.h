@@ -0,0 +1,50 @@
+/*
+ * Copyright 2016 Capital One Services, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GIRAFFEZ_SINK_H
+#define __GIRAFFEZ_SINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "common.h"
+#include "buffer.h"
+#include "encoder.h"
+
+
+// The size of the output buffered by a sink before it is written out.
+#define TEXT_SINK_SIZE (1 << 20)
+
+// Formats rows as delimited text, one per line, into a single buffer that
+// is written to a file descriptor whenever it fills up, rather than
+// creating a string for each row. written counts the bytes written so far.
+typedef struct TextSink {
+    int      fd;
+    buffer_t *buffer;
+    size_t   written;
+} TextSink;
+
+TextSink* text_sink_new(const int fd);
+int       text_sink_rows(TextSink *s, const TeradataEncoder *e, unsigned char *data, const uint32_t length);
+int       text_sink_flush(TextSink *s);
+void      text_sink_free(TextSink *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -371,8 +371,11 @@ PyObject* teradata_handle_parcel_status(TeradataCursor *cursor, const uint32_t p
 PyObject* teradata_handle_parcel_state(TeradataEncoder *encoder, const uint32_t parcel_t, unsigned char **data, const uint32_t length) {
     switch (parcel_t) {
         case PclSTATEMENTINFO:
+            if (encoder_check_idle(encoder) != 0) {
+                return NULL;
+            }
             encoder_clear(encoder);
-            encoder->Columns = encoder->UnpackStmtInfoFunc(data, length);
+            encoder_set_columns(encoder, encoder->UnpackStmtInfoFunc(data, length));
             break;
         case PclSTATEMENTINFOEND:
             PyErr_SetNone(EndStatementInfoError);
@@ -21,6 +21,10 @@
 #include "columns.h"
 #include "convert.h"
 #include "encoder.h"
+#include "pool.h"
+#include "rawblock.h"
+#include "row.h"
+#include "sink.h"
 #include "teradata.h"
 #include <sstream>
 
@@ -36,6 +40,92 @@ namespace Giraffez {
         std::string table_name;
         const char *host, *username, *password, *logon_mech, *logon_mech_data;
         unsigned char *row_buffer;
+        WorkerPool *pool;
+        DecodeJob *jobs;
+        DecodedBlock **blocks;
+        RawBlock *block;
+        bool finished;
+
+        void FreeWorkers() {
+            worker_pool_free(this->pool);
+            free(this->jobs);
+            free(this->blocks);
+            this->pool = NULL;
+            this->jobs = NULL;
+            this->blocks = NULL;
+        }
+
+        // The block last returned by GetBlock refers to the buffer of the
+        // export operator, so it is detached before the operator is used
+        // again. When the operator is about to be freed a block that cannot
+        // be detached is emptied rather than kept.
+        int ReleaseBlock(bool closing=false) {
+            if (this->block == NULL) {
+                return 0;
+            }
+            if (raw_block_detach(this->block) != 0) {
+                if (!closing) {
+                    return -1;
+                }
+                raw_block_empty(this->block);
+                Py_CLEAR(this->block);
+                return -1;
+            }
+            Py_CLEAR(this->block);
+            return 0;
+        }
+
+        // Receives up to one buffer for each worker, decoding each one on
+        // its worker as soon as it arrives, and returns the rows of all of
+        // them in the order they were received. The encoder is held until
+        // the workers are done, since they walk its columns and plan while
+        // the GIL is released to receive the next buffer.
+        PyObject* GetBuffers() {
+            PyObject *rows = NULL;
+            unsigned char *data = NULL;
+            int length;
+            int result;
+            size_t i, n;
+            encoder_hold(encoder);
+            for (n=0; n<pool->length; n++) {
+                Py_BEGIN_ALLOW_THREADS
+                result = (int)this->conn->GetBuffer((char**)&data, (TD_Length*)&length);
+                Py_END_ALLOW_THREADS
+                if (result == TD_END_METHOD) {
+                    finished = true;
+                    break;
+                }
+                if (decode_job_init(&jobs[n], encoder, data, length) != 0) {
+                    break;
+                }
+                worker_pool_submit(pool, n, decode_job_run, &jobs[n]);
+            }
+            Py_BEGIN_ALLOW_THREADS
+            for (i=0; i<n; i++) {
+                worker_pool_wait(pool, i);
+            }
+            Py_END_ALLOW_THREADS
+            encoder_release(encoder);
+            if (PyErr_Occurred()) {
+                goto error;
+            }
+            if (n == 0) {
+                Py_RETURN_NONE;
+            }
+            for (i=0; i<n; i++) {
+                if (jobs[i].status != DECODE_OK) {
+                    decoded_block_set_error(jobs[i].status);
+                    goto error;
+                }
+                blocks[i] = jobs[i].block;
+            }
+            rows = teradata_blocks_to_pylist(encoder, blocks, n);
+error:
+            for (i=0; i<n; i++) {
+                decode_job_clear(&jobs[i]);
+            }
+            return rows;
+        }
     public:
         teradata::client::API::Connection *conn;
         TeradataEncoder *encoder;
@@ -57,10 +147,19 @@ namespace Giraffez {
                 this->logon_mech_data = NULL;
             }
             this->row_buffer = (unsigned char*)malloc(sizeof(unsigned char)*TD_ROW_MAX_SIZE);
+            this->pool = NULL;
+            this->jobs = NULL;
+            this->blocks = NULL;
+            this->block = NULL;
+            this->finished = false;
             this->encoder = encoder_new(NULL, 0);
             this->conn = new teradata::client::API::Connection();
         }
         ~Connection() {
+            this->FreeWorkers();
+            if (this->ReleaseBlock(true) != 0) {
+                PyErr_Clear();
+            }
             if (encoder != NULL) {
                 encoder_free(encoder);
                 encoder = NULL;
@@ -89,6 +188,29 @@ namespace Giraffez {
             Py_RETURN_NONE;
         }
 
+        // Buffers are decoded on the calling thread unless more than one
+        // worker is requested.
+        PyObject* SetWorkers(int workers) {
+            if (encoder_check_idle(encoder) != 0) {
+                return NULL;
+            }
+            this->FreeWorkers();
+            if (workers <= 1) {
+                Py_RETURN_NONE;
+            }
+            this->jobs = (DecodeJob*)malloc(workers * sizeof(DecodeJob));
+            this->blocks = (DecodedBlock**)malloc(workers * sizeof(DecodedBlock*));
+            if (this->jobs == NULL || this->blocks == NULL) {
+                this->FreeWorkers();
+                return PyErr_NoMemory();
+            }
+            if ((this->pool = worker_pool_new(workers)) == NULL) {
+                this->FreeWorkers();
+                return NULL;
+            }
+            Py_RETURN_NONE;
+        }
+
         void AddAttribute(TD_Attribute key, const char *value) {
             this->conn->AddAttribute(key, (char*)value);
         }
@@ -163,12 +285,94 @@ namespace Giraffez {
         PyObject* GetBuffer() {
             unsigned char *data = NULL;
             int length;
-            if ((int)this->conn->GetBuffer((char**)&data, (TD_Length*)&length) == TD_END_METHOD) {
+            int result;
+            if (finished) {
+                Py_RETURN_NONE;
+            }
+            if (this->ReleaseBlock() != 0) {
+                return NULL;
+            }
+            if (pool != NULL && teradata_buffer_decodable(encoder)) {
+                return this->GetBuffers();
+            }
+            // The export operator blocks while the next buffer is received
+            // from the server, so other threads are allowed to run.
+            Py_BEGIN_ALLOW_THREADS
+            result = (int)this->conn->GetBuffer((char**)&data, (TD_Length*)&length);
+            Py_END_ALLOW_THREADS
+            if (result == TD_END_METHOD) {
+                finished = true;
                 Py_RETURN_NONE;
             }
             return encoder->UnpackRowsFunc(encoder, &data, length);
         }
 
+        // Returns the next buffer received from the server as a block of
+        // raw rows, without copying it, or None at the end of the export.
+        PyObject* GetBlock() {
+            unsigned char *data = NULL;
+            int length;
+            int result;
+            if (finished) {
+                Py_RETURN_NONE;
+            }
+            if (this->ReleaseBlock() != 0) {
+                return NULL;
+            }
+            Py_BEGIN_ALLOW_THREADS
+            result = (int)this->conn->GetBuffer((char**)&data, (TD_Length*)&length);
+            Py_END_ALLOW_THREADS
+            if (result == TD_END_METHOD) {
+                finished = true;
+                Py_RETURN_NONE;
+            }
+            Py_RETURN_ERROR(this->block = raw_block_new((char*)data, length));
+            Py_INCREF(this->block);
+            return (PyObject*)this->block;
+        }
+
+        // Writes the rows of the buffers received from the server to fd
+        // as text until at least TEXT_SINK_SIZE bytes have been written or
+        // the export ends, and returns the number of rows written.
+        PyObject* WriteTo(int fd) {
+            TextSink *sink;
+            unsigned char *data = NULL;
+            int length;
+            int result;
+            int n;
+            long rows = 0;
+            if (finished) {
+                Py_RETURN_NONE;
+            }
+            if (this->ReleaseBlock() != 0) {
+                return NULL;
+            }
+            Py_RETURN_ERROR(sink = text_sink_new(fd));
+            while (sink->written == 0) {
+                Py_BEGIN_ALLOW_THREADS
+                result = (int)this->conn->GetBuffer((char**)&data, (TD_Length*)&length);
+                Py_END_ALLOW_THREADS
+                if (result == TD_END_METHOD) {
+                    finished = true;
+                    break;
+                }
+                if ((n = text_sink_rows(sink, encoder, data, length)) < 0) {
+                    text_sink_free(sink);
+                    return NULL;
+                }
+                rows += n;
+            }
+            if (text_sink_flush(sink) != 0) {
+                text_sink_free(sink);
+                return NULL;
+            }
+            text_sink_free(sink);
+            if (finished && rows == 0) {
+                Py_RETURN_NONE;
+            }
+            return PyLong_FromLong(rows);
+        }
+
         PyObject* GetEvent(TD_EventType event_type, TD_Index index) {
             char *data = NULL;
             TD_Length length = 0;
@@ -184,6 +388,7 @@ namespace Giraffez {
                 return this->HandleError();
             }
             connected = true;
+            finished = false;
             Py_RETURN_NONE;
         }
 
@@ -225,13 +430,19 @@ namespace Giraffez {
             Py_RETURN_NONE;
         }
 
+        // The session is terminated even when the last block could not be
+        // kept, in which case the error is raised afterwards.
         PyObject* Terminate() {
+            int released = this->ReleaseBlock(true);
             if (connected) {
                 if ((status = this->conn->Terminate()) >= TD_ERROR) {
                     return this->HandleError();
                 }
                 connected = false;
             }
+            if (released != 0) {
+                return NULL;
+            }
             Py_RETURN_NONE;
         }
 
@@ -312,6 +523,9 @@ error:
         PyObject* SetQuery(const char *query) {
             TeradataConnection *cmd;
             TeradataCursor *cursor;
+            if (encoder_check_idle(encoder) != 0) {
+                return NULL;
+            }
             encoder_clear(encoder);
             cursor = cursor_new(query);
             cursor->req_proc_opt = 'P';
@@ -334,6 +548,9 @@ error:
         PyObject* SetTable(char *tbl_name) {
             TeradataConnection *cmd;
             TeradataCursor *cursor;
+            if (encoder_check_idle(encoder) != 0) {
+                return NULL;
+            }
             encoder_clear(encoder);
             table_name = std::string(tbl_name);
             cursor = cursor_new(strdup(("select top 1 * from " + table_name).c_str()));
@@ -399,7 +616,7 @@ error:
                         }
                     }
                 }
-                encoder->Columns = ncolumns;
+                encoder_set_columns(encoder, ncolumns);
             }
             // TODO: May not be necessary to specify the column names, since it
             // appears to pull that from what is added via AddColumn (possibly)
@@ -180,12 +180,21 @@ class TeradataExtension(Extension):
     name = "giraffez._teradata"
 
     sources = [
+        "giraffez/src/array.c",
+        "giraffez/src/arrow.c",
+        "giraffez/src/block.c",
         "giraffez/src/buffer.c",
         "giraffez/src/columns.c",
         "giraffez/src/convert.c",
+        "giraffez/src/dedup.c",
         "giraffez/src/encoder.c",
         "giraffez/src/errors.c",
+        "giraffez/src/filter.c",
+        "giraffez/src/lazy.c",
+        "giraffez/src/pool.c",
+        "giraffez/src/rawblock.c",
         "giraffez/src/row.c",
+        "giraffez/src/sink.c",
         "giraffez/src/teradata.c",
         "giraffez/_teradatamodule.c",
     ]
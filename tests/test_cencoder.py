@@ -598,6 +598,817 @@ class TestEncoder(object):
         result_text = encoder.read(expected_bytes)
         assert result_text == expected_text
 
+    def test_decode_plan_settings(self, encoder):
+        """
+        Ensure that adjacent columns of the same type are decoded correctly
+        and that changing the encoding after the columns are set is
+        reflected in the decoded values.
+        """
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_INTEGER, 4, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_DECIMAL, 4, 8, 2),
+            ('col5', TD_DATE, 4, 0, 0),
+        ]
+        expected_bytes = b'\x40\x01\x00\x00\x00\x00\x00\x00\x00\xd2\x04\x00\x00.\xfb\xff\xff\x8b\x90\x11\x00'
+        result_text = encoder.read(expected_bytes)
+        assert result_text == (1, None, "12.34", "-12.34", "2015-11-15")
+
+        encoder |= DECIMAL_AS_FLOAT
+        result_text = encoder.read(expected_bytes)
+        assert result_text == (1, None, 12.34, -12.34, "2015-11-15")
+
+        encoder |= DATETIME_AS_GIRAFFE_TYPES
+        result_text = encoder.read(expected_bytes)
+        assert result_text[4] == datetime.datetime(2015, 11, 15)
+
+    def test_null_indicator_wide_row(self, encoder):
+        """
+        Ensure that null indicators spanning more than one 64-bit word are
+        read correctly, with and without nulls present in the row.
+        """
+        import struct
+        encoder.columns = [('col{}'.format(i), TD_INTEGER, 4, 0, 0) for i in range(70)]
+        values = struct.pack('<70i', *range(70))
+        result = encoder.read(b'\x00' * 9 + values)
+        assert result == tuple(range(70))
+
+        header = bytearray(9)
+        header[8] |= 0x80 >> (68 % 8)
+        header[0] |= 0x80
+        result = encoder.read(bytes(header) + values)
+        expected = list(range(70))
+        expected[0] = None
+        expected[68] = None
+        assert result == tuple(expected)
+
+    def test_dict_row_keys(self, encoder):
+        """
+        Ensure that rows decoded as dicts share the same key objects.
+        """
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_SMALLINT, 2, 0, 0),
+        ]
+        encoder |= ENCODER_SETTINGS_JSON
+        first = encoder.read(b'\x00\x01\x00\x00\x00\x02\x00')
+        second = encoder.read(b'\x40\x03\x00\x00\x00\x00\x00')
+        assert first == {"col1": 1, "col2": 2}
+        assert second == {"col1": 3, "col2": None}
+        assert [id(k) for k in sorted(first)] == [id(k) for k in sorted(second)]
+
+    def test_namedtuple_rows(self, encoder):
+        """
+        Ensure that rows decoded as named tuples have a field for each
+        projected column and that the row type follows the columns.
+        """
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_SMALLINT, 2, 0, 0),
+        ]
+        encoder |= ROW_ENCODING_NAMEDTUPLE
+        data = b'\x20\x01\x00\x00\x00\x06\x00value2\x00\x00'
+        row = encoder.read(data)
+        assert row == (1, "value2", None)
+        assert (row.col1, row.col2, row.col3) == (1, "value2", None)
+        assert type(row)._fields == ("col1", "col2", "col3")
+        assert type(encoder.read(data)) is type(row)
+
+        encoder.projection = ["col3", "col2"]
+        row = encoder.read(data)
+        assert row == ("value2", None)
+        assert row.col2 == "value2"
+        assert not hasattr(row, "col1")
+
+    def test_unpack_text(self, encoder):
+        """
+        Ensure that ASCII and non-ASCII text of any length is decoded the
+        same, including non-ASCII bytes at the end of a long value.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_VARCHAR, 100, 0, 0),
+        ]
+        for value in ["", "a", "x" * 15, "y" * 16, "z" * 40, "z" * 40 + u"é", u"été"]:
+            raw = value.encode("utf-8")
+            assert encoder.read(b'\x00' + struct.pack('<H', len(raw)) + raw) == (value,)
+
+    def test_trim_chars(self, encoder):
+        """
+        Ensure that CHAR padding is only removed with CHAR_AS_TRIMMED and
+        that the format length counts characters rather than bytes.
+        """
+        encoder.columns = [
+            ('col1', TD_CHAR, 6, 0, 0),
+            ('col2', TD_CHAR, 9, 0, 0, "N", None, "X(3)"),
+        ]
+        data = b'\x00ab    ' + u"ééa    ".encode("utf-8")
+        assert encoder.read(data) == ("ab    ", u"ééa")
+
+        encoder |= CHAR_AS_TRIMMED
+        assert encoder.read(data) == ("ab", u"ééa")
+        assert encoder.read(b'\x00      ' + b' ' * 9) == ("", "")
+
+        encoder |= ENCODER_SETTINGS_STRING
+        assert encoder.read(data) == u"ab|ééa"
+
+        encoder |= CHAR_AS_PADDED
+        assert encoder.read(data) == u"ab    |ééa    "
+
+    def test_quoting(self, encoder):
+        """
+        Ensure that text values are quoted only when they contain the
+        delimiter, a double quote or a line break, including past the
+        first 16 bytes of a value.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_VARCHAR, 100, 0, 0),
+            ('col2', TD_INTEGER, 4, 0, 0),
+            ('col3', TD_VARCHAR, 100, 0, 0),
+        ]
+        def row(a, i, b):
+            a, b = a.encode("utf-8"), b.encode("utf-8")
+            return b'\x00' + struct.pack('<H', len(a)) + a + struct.pack('<iH', i, len(b)) + b
+        encoder |= ENCODER_SETTINGS_STRING
+        assert encoder.read(row(u'a|b', 1, u'"x"')) == u'a|b|1|"x"'
+
+        encoder.quoting = True
+        assert encoder.read(row(u'a|b', 1, u'"x"')) == u'"a|b"|1|"""x"""'
+        assert encoder.read(row(u'plain', -2, u'')) == u'plain|-2|'
+        assert encoder.read(row(u'x' * 40 + u'\n', 3, u'y' * 17 + u'\r')) == \
+            u'"' + u'x' * 40 + u'\n"|3|"' + u'y' * 17 + u'\r"'
+
+        encoder.delimiter = u'::'
+        assert encoder.read(row(u'a:b', 1, u'c::d')) == u'a:b::1::"c::d"'
+
+    def test_json_rows(self, encoder):
+        """
+        Ensure that rows encoded as JSON are the same as the decoded dicts
+        written with json.dumps, including escaped strings, floats, nulls
+        and projection.
+        """
+        import json
+        import struct
+        encoder.columns = [
+            ('col1', TD_VARCHAR, 100, 0, 0),
+            ('col2', TD_INTEGER, 4, 0, 0),
+            ('col3', TD_FLOAT, 8, 0, 0),
+            ('col4', TD_DECIMAL, 4, 8, 2),
+            ('col5', TD_CHAR, 4, 0, 0),
+        ]
+        def row(s, i, d, q):
+            s = s.encode("utf-8")
+            return b'\x00' + struct.pack('<H', len(s)) + s + struct.pack('<idi', i, d, q) + b'ab  '
+        rows = [
+            row(u'plain', 1, 1.0, 12345),
+            row(u'"quoted" \\ tab\t nl\n \x01 caf\xe9 \u263a', -2, 0.1, -5),
+            row(u'', 2147483647, 1e100, 0),
+            b'\xa8' + struct.pack('<H', 0) + struct.pack('<idi', 0, 0, 0) + b'    ',
+        ]
+        for settings in (DECIMAL_AS_FLOAT, DECIMAL_AS_STRING):
+            for projection in (None, ["col5", "col1", "col3"]):
+                encoder.projection = projection
+                encoder |= ROW_ENCODING_DICT | settings
+                expected = [json.dumps(encoder.read(data), ensure_ascii=False) for data in rows]
+                encoder |= ROW_ENCODING_JSON
+                assert [encoder.read(data) for data in rows] == expected
+
+        encoder.projection = ["col1"]
+        assert encoder.read(rows[0]) == u'{"col1": "plain"}'
+
+    def test_integer_text(self, encoder):
+        """
+        Ensure that integers and decimals are formatted correctly as text,
+        including the limits of each type and values between -1 and 1.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_BYTEINT, 1, 0, 0),
+            ('col2', TD_SMALLINT, 2, 0, 0),
+            ('col3', TD_INTEGER, 4, 0, 0),
+            ('col4', TD_BIGINT, 8, 0, 0),
+            ('col5', TD_DECIMAL, 8, 18, 4),
+            ('col6', TD_DECIMAL, 2, 4, 0),
+        ]
+        encoder |= ENCODER_SETTINGS_STRING
+        def row(*values):
+            return b'\x00' + struct.pack('<bhiqqh', *values)
+        assert encoder.read(row(-128, -32768, -2**31, -2**63, -2**63, -32768)) == \
+            u'-128|-32768|-2147483648|-9223372036854775808|-922337203685477.5808|-32768'
+        assert encoder.read(row(127, 32767, 2**31-1, 2**63-1, 2**63-1, 32767)) == \
+            u'127|32767|2147483647|9223372036854775807|922337203685477.5807|32767'
+        assert encoder.read(row(0, 9, 10, 99, -5, 0)) == u'0|9|10|99|-0.0005|0'
+        assert encoder.read(row(-1, 100, -1000, 10**18, 10**4, -1)) == \
+            u'-1|100|-1000|1000000000000000000|1.0000|-1'
+
+        encoder |= ENCODER_SETTINGS_DEFAULT
+        encoder |= DECIMAL_AS_STRING
+        assert encoder.read(row(-7, 12, 345, -6789, 123456, 10)) == \
+            (-7, 12, 345, -6789, "12.3456", "10")
+
+    def test_float_text(self, encoder):
+        """
+        Ensure that floats are formatted as the shortest text that reads
+        back as the same value, in text and JSON rows, including powers of
+        2 and 10, subnormals and doubles of any bit pattern.
+        """
+        import random
+        import struct
+        encoder.columns = [
+            ('col1', TD_FLOAT, 8, 0, 0),
+        ]
+        values = [0.1 + 0.2, 1.0, -0.0, 5e-324, 1.7976931348623157e+308, 1e16, 123456789.125, 2.0 / 3,
+            7.120236347223045e-307, 2.2250738585072014e-308, 2.225073858507201e-308, 1e-05, 0.0001]
+        values += [2.0 ** k for k in range(-1074, 1024, 5)] + [10.0 ** k for k in range(-323, 309, 3)]
+        r = random.Random(0)
+        for i in range(5000):
+            value = struct.unpack('<d', struct.pack('<Q', r.getrandbits(64)))[0]
+            if value == value and abs(value) != float('inf'):
+                values.append(value)
+        encoder |= ENCODER_SETTINGS_STRING
+        for value in values:
+            text = encoder.read(b'\x00' + struct.pack('<d', value))
+            assert float(text) == value and len(text) <= len(repr(value))
+        assert encoder.read(b'\x00' + struct.pack('<d', 0.1 + 0.2)) == u'0.30000000000000004'
+        assert encoder.read(b'\x00' + struct.pack('<d', 2.0)) == u'2'
+
+        encoder |= ROW_ENCODING_JSON
+        for value in values:
+            assert encoder.read(b'\x00' + struct.pack('<d', value)) == u'{"col1": %s}' % repr(value)
+
+    def test_decimal_as_float(self, encoder):
+        """
+        Ensure that decimals and numbers converted straight to floats are
+        the same as parsing their text, on both sides of 2**53.
+        """
+        import random
+        import struct
+        def le(v, n):
+            return bytes(bytearray((v >> (8 * i)) & 0xff for i in range(n)))
+        values = [0, 1, -1, 5, -5, 2**53 - 1, 2**53, 2**53 + 1, -2**53 - 1, 10**15 + 7]
+        values += [random.randint(-2**62, 2**62) for _ in range(50)]
+        for length, precision in ((1, 2), (2, 4), (4, 9), (8, 18), (16, 38)):
+            for scale in (0, 2, precision):
+                encoder.columns = [('col1', TD_DECIMAL, length, precision, scale)]
+                bits = 8 * length
+                for v in values + [2**(bits - 1) - 1, -2**(bits - 1), 10**37 + 3]:
+                    v = (v + 2**(bits - 1)) % 2**bits - 2**(bits - 1)
+                    data = b'\x00' + le(v, length)
+                    encoder |= ENCODER_SETTINGS_DEFAULT
+                    encoder |= DECIMAL_AS_STRING
+                    expected = float(encoder.read(data)[0])
+                    encoder |= DECIMAL_AS_FLOAT
+                    assert encoder.read(data) == (expected,)
+        encoder.columns = [('col1', NUMBER_NN, 16, 38, 0)]
+        for v in values + [10**37 + 3, -10**30]:
+            n = len(le(abs(v) * 2 + 1, 16).rstrip(b'\x00')) or 1
+            for scale in (0, 3, 25, -4):
+                data = b'\x00' + struct.pack('<bh', n + 2, scale) + le(v, n)
+                encoder |= ENCODER_SETTINGS_DEFAULT
+                encoder |= DECIMAL_AS_STRING
+                expected = float(encoder.read(data)[0])
+                encoder |= DECIMAL_AS_FLOAT
+                assert encoder.read(data) == (expected,)
+
+    def test_number_text(self, encoder):
+        """
+        Ensure that numbers are formatted correctly across the full 128-bit
+        range of the unscaled value, with positive and negative scales.
+        """
+        import struct
+        encoder.columns = [('col1', NUMBER_NN, 16, 38, 0)]
+        encoder |= ENCODER_SETTINGS_DEFAULT
+        encoder |= DECIMAL_AS_STRING
+        def number(v, scale, n=16):
+            return b'\x00' + struct.pack('<bh', n + 2, scale) + \
+                bytes(bytearray((v >> (8 * i)) & 0xff for i in range(n)))
+        assert encoder.read(number(-5, -3, 1)) == ("-5000",)
+        assert encoder.read(number(-2**127, 38)) == ("-1.70141183460469231731687303715884105728",)
+        assert encoder.read(number(2**127 - 1, 0)) == ("170141183460469231731687303715884105727",)
+        assert encoder.read(number(10**19, 19)) == ("1.0000000000000000000",)
+        assert encoder.read(number(7, 5, 9)) == ("0.00007",)
+
+        encoder.columns = [('col1', TD_DECIMAL, 16, 38, 38)]
+        assert encoder.read(b'\x00' + struct.pack('<Qq', 0, -2**63)) == \
+            ("-1.70141183460469231731687303715884105728",)
+
+    def test_decimal_as_scaled_int(self, encoder):
+        """
+        Ensure that decimals and numbers are returned as their unscaled
+        values, with numbers rescaled to the scale of the column.
+        """
+        import random
+        import struct
+        def le(v, n):
+            return bytes(bytearray((v >> (8 * i)) & 0xff for i in range(n)))
+        values = [0, 1, -1, 2**63 - 1, -2**63, 2**63, 2**127 - 1, -2**127]
+        values += [random.randint(-2**126, 2**126) for _ in range(50)]
+        for length, precision in ((1, 2), (2, 4), (4, 9), (8, 18), (16, 38)):
+            encoder.columns = [('col1', TD_DECIMAL, length, precision, 2)]
+            encoder |= ENCODER_SETTINGS_DEFAULT
+            encoder |= DECIMAL_AS_SCALED_INT
+            bits = 8 * length
+            for v in values:
+                v = (v + 2**(bits - 1)) % 2**bits - 2**(bits - 1)
+                assert encoder.read(b'\x00' + le(v, length)) == (v,)
+                encoder |= ROW_ENCODING_JSON
+                assert encoder.read(b'\x00' + le(v, length)) == u'{"col1": %d}' % v
+                encoder |= ROW_ENCODING_LIST
+
+        encoder.columns = [('col1', NUMBER_NN, 16, 18, 2)]
+        def number(v, scale, n=16):
+            return b'\x00' + struct.pack('<bh', n + 2, scale) + le(v, n)
+        assert encoder.read(number(1234, 2)) == (1234,)
+        assert encoder.read(number(-5, -3, 1)) == (-500000,)
+        assert encoder.read(number(1230, 3, 2)) == (123,)
+        assert encoder.read(b'\x00\x00') == (0,)
+        assert encoder.read(number(-2**125, 2)) == (-2**125,)
+        with pytest.raises(EncoderError):
+            encoder.read(number(1234, 3))
+        with pytest.raises(EncoderError):
+            encoder.read(number(2**126, 0))
+
+        encoder.columns = [
+            ('col1', TD_DECIMAL, 4, 8, 2),
+            ('col2', TD_DECIMAL, 16, 38, 2),
+            ('col3', NUMBER_NN, 16, 18, 2),
+        ]
+        row = b'\x00' + le(1234, 4) + le(-2**100, 16) + number(-5, 0, 1)[1:]
+        columns = encoder.readcolumns(struct.pack('<H', len(row)) + row)
+        assert memoryview(columns[0][2]).tolist() == [1234]
+        assert memoryview(columns[1][2]).format == '2q'
+        assert struct.unpack('<Qq', memoryview(columns[1][2]).tobytes()) == (0, -2**36)
+        assert memoryview(columns[2][2]).tolist() == [-500]
+
+    def test_dedup(self, encoder):
+        """
+        Ensure that repeated values of deduplicated columns share a single
+        object and that other columns are unaffected.
+        """
+        encoder.columns = [
+            ('col1', TD_CHAR, 2, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DATE, 4, 0, 0),
+            ('col4', TD_VARCHAR, 50, 0, 0),
+        ]
+        data = b'\x00US\x02\x00ok\x8b\x90\x11\x00\x02\x00ok'
+        first, second = encoder.read(data), encoder.read(data)
+        assert first == second == ("US", "ok", "2015-11-15", "ok")
+        assert first[1] is not second[1]
+
+        encoder.dedup = True
+        first, second = encoder.read(data), encoder.read(data)
+        assert first == second == ("US", "ok", "2015-11-15", "ok")
+        assert all(a is b for a, b in zip(first, second))
+        assert encoder.read(b'\x00CA\x02\x00no\x8b\x90\x11\x00\x00\x00') == ("CA", "no", "2015-11-15", "")
+
+        encoder.dedup = ["col2"]
+        first, second = encoder.read(data), encoder.read(data)
+        assert first[1] is second[1]
+        assert first[3] is not second[3]
+
+        with pytest.raises(EncoderError):
+            encoder.dedup = ["col5"]
+
+    def test_projection(self, encoder):
+        """
+        Ensure that only the projected columns are decoded, skipping fixed
+        and variable width columns, nulls included, in every row encoding.
+        """
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_INTEGER, 4, 0, 0),
+            ('col5', TD_VARCHAR, 50, 0, 0),
+            ('col6', TD_SMALLINT, 2, 0, 0),
+        ]
+        data = b'\x20\x01\x00\x00\x00\x06\x00value2\x00\x00\x00\x00\x04\x00\x00\x00\x06\x00value5\x06\x00'
+        assert encoder.read(data) == (1, "value2", None, 4, "value5", 6)
+
+        encoder.projection = ["COL4", "col2", "col6"]
+        assert encoder.read(data) == ("value2", 4, 6)
+
+        encoder.projection = ["col5"]
+        assert encoder.read(data) == ("value5",)
+
+        encoder |= ENCODER_SETTINGS_JSON
+        encoder.projection = ["col3", "col6"]
+        assert encoder.read(data) == {"col3": None, "col6": 6}
+
+        encoder |= ENCODER_SETTINGS_STRING
+        encoder.null = "NULL"
+        assert encoder.read(data) == "NULL|6"
+
+        encoder.projection = None
+        assert encoder.read(data) == "1|value2|NULL|4|value5|6"
+
+        with pytest.raises(EncoderError):
+            encoder.projection = ["col7"]
+
+    def test_filter(self, encoder):
+        """
+        Ensure that rows are filtered on the raw bytes before decoding with
+        comparisons, null tests and IN sets.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_CHAR, 4, 0, 0),
+            ('col5', TD_DATE, 4, 0, 0),
+        ]
+        def row(header, i, s, d, c, date):
+            data = struct.pack('<BiH', header, i, len(s)) + s + struct.pack('<i', d) + c + struct.pack('<i', date)
+            return struct.pack('<H', len(data)) + data
+        data = row(0, 1, b'one', 1234, b'ab  ', 1151115) + \
+            row(0x20, 2, b'two', 0, b'cd  ', 1151116) + \
+            row(0, 3, b'three', -1234, b'ab  ', 1160101)
+        assert [r[0] for r in encoder.readbuffer(data)] == [1, 2, 3]
+
+        encoder.filter = [('col1', '>', 1)]
+        assert [r[0] for r in encoder.readbuffer(data)] == [2, 3]
+
+        encoder.filter = [('col2', 'in', {'one', 'three'}), ('col1', '!=', 1)]
+        assert [r[0] for r in encoder.readbuffer(data)] == [3]
+
+        encoder.filter = [('col3', 'is null')]
+        assert [r[0] for r in encoder.readbuffer(data)] == [2]
+
+        encoder.filter = [('col3', '<', '12.34')]
+        assert [r[0] for r in encoder.readbuffer(data)] == [3]
+
+        encoder.filter = [('col4', '=', 'ab'), ('col5', '>=', datetime.date(2015, 11, 16))]
+        assert [r[0] for r in encoder.readbuffer(data)] == [3]
+
+        encoder.filter = [('col5', 'in', ['2015-11-15', '2015-11-16'])]
+        assert [r[0] for r in encoder.readbuffer(data)] == [1, 2]
+
+        encoder.filter = None
+        assert len(encoder.readbuffer(data)) == 3
+
+        with pytest.raises(EncoderError):
+            encoder.filter = [('col9', '=', 1)]
+        with pytest.raises(EncoderError):
+            encoder.filter = [('col1', 'like', 1)]
+        with pytest.raises(EncoderError):
+            encoder.filter = [('col3', '=', '1.234')]
+
+    def test_filter_after_null(self, encoder):
+        """
+        Ensure that a null variable width column, which is sent with the
+        null length of its column rather than a length prefix, is skipped
+        to find the columns filtered after it.
+        """
+        import struct
+        for column in [('col1', TD_VARBYTE, 10, 0, 0), ('col1', TD_NUMBER, 18, 0, 0)]:
+            encoder.columns = [column, ('col2', TD_INTEGER, 4, 0, 0)]
+            encoder.filter = None
+            data = b'\x80' + b'\x00' * column[2] + struct.pack('<i', 5)
+            data = struct.pack('<H', len(data)) + data
+            assert encoder.readbuffer(data) == [(None, 5)]
+
+            encoder.filter = [('col2', '=', 5)]
+            assert encoder.readbuffer(data) == [(None, 5)]
+            encoder.filter = [('col2', '!=', 5)]
+            assert encoder.readbuffer(data) == []
+
+    def test_readbuffer_block(self, encoder):
+        """
+        Ensure that rows decoded a block at a time match the same rows
+        decoded one at a time, with nulls, projection and deduplication.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_BYTEINT, 1, 0, 0),
+            ('col2', TD_BIGINT, 8, 0, 0),
+            ('col3', TD_FLOAT, 8, 0, 0),
+            ('col4', TD_DECIMAL, 8, 12, 3),
+            ('col5', TD_CHAR, 4, 0, 0),
+            ('col6', TD_VARCHAR, 50, 0, 0),
+            ('col7', TD_DATE, 4, 0, 0),
+            ('col8', TD_TIME, 8, 0, 0),
+            ('col9', TD_TIMESTAMP, 19, 0, 0),
+            ('col10', TD_VARBYTE, 10, 0, 0),
+        ]
+        def row(header, b, q, d, n, c, s, date, t, ts, v):
+            return bytes(bytearray(header)) + struct.pack('<bqdq', b, q, d, n) + c + \
+                struct.pack('<H', len(s)) + s + struct.pack('<i', date) + t + ts + \
+                struct.pack('<H', len(v)) + v
+        rows = [
+            row([0, 0], -3, 2**40, 1.5, -123456, b'ab  ', u"été".encode("utf-8"), 1151115,
+                b'10:11:12', b'2015-11-15 10:11:12', b'\x01\x02'),
+            row([0x52, 0x80], 0, 0, 0.0, 0, b'    ', b'', 0, b'00:00:00', b'0000-00-00 00:00:00', b''),
+            row([0, 0], 7, -1, -2.25, 5, b'ab  ', u"été".encode("utf-8"), 1160101,
+                b'23:59:59', b'2016-01-01 00:00:00', b'\xff'),
+        ]
+        data = b''.join(struct.pack('<H', len(r)) + r for r in rows)
+        for settings in [0, ROW_ENCODING_DICT, ROW_ENCODING_NAMEDTUPLE, DATETIME_AS_GIRAFFE_TYPES,
+                DECIMAL_AS_FLOAT, DECIMAL_AS_GIRAFFEZ_DECIMAL, CHAR_AS_TRIMMED]:
+            encoder |= settings
+            assert encoder.readbuffer(data) == [encoder.read(r) for r in rows]
+        assert encoder.readbuffer(data)[1][1] is None
+
+        encoder.projection = ["col9", "col6", "col2"]
+        encoder.dedup = True
+        result = encoder.readbuffer(data)
+        assert result == [encoder.read(r) for r in rows]
+        assert result[0][1] is result[2][1]
+        assert result[1] == (None, "", None)
+
+    def test_writebuffer(self, encoder, tmpdir):
+        """
+        Ensure that rows written as text to a file match the strings of the
+        same rows, with projection, filtering and many more rows than fit
+        in a single write.
+        """
+        import os, struct
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+        ]
+        def row(header, i, s, d):
+            data = struct.pack('<BiH', header, i, len(s)) + s + struct.pack('<i', d)
+            return struct.pack('<H', len(data)) + data
+        data = b''.join(row(0x20 if i % 3 == 0 else 0, i, u"é{}".format(i).encode("utf-8"), i * 7)
+            for i in range(2000))
+        encoder |= ENCODER_SETTINGS_STRING
+        encoder.null = "NULL"
+        path = str(tmpdir.join("rows.txt"))
+        for projection, predicates in [(None, None), (["col3", "col1"], [('col1', '>=', 1500)])]:
+            encoder.projection = projection
+            encoder.filter = predicates
+            expected = encoder.readbuffer(data * 100)
+            with open(path, "wb") as f:
+                assert encoder.writebuffer(f.fileno(), data * 100) == len(expected)
+            with open(path, "rb") as f:
+                assert f.read().decode("utf-8") == u"".join(r + u"\n" for r in expected)
+
+    def test_text_longer_than_row(self, encoder, tmpdir):
+        """
+        Ensure that rows that are much longer as text than in the raw row,
+        such as those with many wide decimals, are formatted in full.
+        """
+        import struct
+        n = 2048
+        encoder.columns = [('col{}'.format(i), TD_DECIMAL, 16, 38, 38) for i in range(n)]
+        encoder |= ENCODER_SETTINGS_STRING
+        row = b'\x00' * (n // 8) + struct.pack('<qq', 1, 0) * n
+        expected = u"|".join([u"0." + u"0" * 37 + u"1"] * n)
+        assert encoder.read(row) == expected
+
+        path = str(tmpdir.join("rows.txt"))
+        data = struct.pack('<H', len(row)) + row
+        with open(path, "wb") as f:
+            assert encoder.writebuffer(f.fileno(), data * 40) == 40
+        with open(path, "rb") as f:
+            assert f.read().decode("utf-8") == (expected + u"\n") * 40
+
+    def test_lazy_rows(self, encoder):
+        """
+        Ensure that lazy rows decode columns on access by index and name,
+        before and after a variable width column, and outlive changes to
+        the encoder columns.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_VARCHAR, 50, 0, 0),
+            ('col5', TD_SMALLINT, 2, 0, 0),
+        ]
+        def row(header, i, s, d, t, h):
+            data = struct.pack('<BiH', header, i, len(s)) + s + struct.pack('<iH', d, len(t)) + t + \
+                struct.pack('<h', h)
+            return struct.pack('<H', len(data)) + data
+        data = row(0, 1, b'one', 1234, b'a', 10) + row(0x20, 2, b'two', 0, b'bb', 20)
+        encoder |= ROW_ENCODING_LAZY
+        rows = encoder.readbuffer(data)
+        assert len(rows) == 2
+        assert rows[0]["col5"] == 10
+        assert rows[0][-2] == "a"
+        assert rows[0][0] == 1
+        assert rows[1]["COL2"] == "two"
+        assert rows[1][2] is None
+        assert len(rows[1]) == 5
+        assert tuple(rows[1]) == (2, "two", None, "bb", 20)
+        assert dict(rows[0]) == {"col1": 1, "col2": "one", "col3": "12.34", "col4": "a", "col5": 10}
+        assert repr(rows[0]) == repr((1, "one", "12.34", "a", 10))
+        with pytest.raises(KeyError):
+            rows[0]["col6"]
+        with pytest.raises(IndexError):
+            rows[0][5]
+
+        encoder.columns = [('col1', TD_INTEGER, 4, 0, 0)]
+        assert rows[1][3] == "bb"
+
+    def test_unpack_columns(self, encoder):
+        """
+        Ensure that a block of rows is decoded into per-column arrays with
+        a validity bitmap that marks nulls.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_DATE, 4, 0, 0),
+        ]
+        rows = [
+            b'\x00*\x00\x00\x00\x03\x00abc\xd2\x04\x00\x00\x8b\x90\x11\x00',
+            b'\xc0\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x8b\x90\x11\x00',
+            b'\x00\x07\x00\x00\x00\x02\x00de\x00\x00\x00\x00\x8b\x90\x11\x00',
+        ]
+        block = b''.join(struct.pack('<H', len(row)) + row for row in rows)
+        columns = encoder.readcolumns(block)
+        assert len(columns) == 4
+
+        validity, offsets, values = columns[0]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x05])
+        assert offsets is None
+        assert memoryview(values).format == 'q'
+        assert list(memoryview(values).tolist()) == [42, 0, 7]
+
+        validity, offsets, values = columns[1]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x05])
+        assert list(memoryview(offsets).tolist()) == [0, 3, 3, 5]
+        assert memoryview(values).tobytes() == b'abcde'
+
+        validity, offsets, values = columns[2]
+        assert list(memoryview(values).tolist()) == [12.34, 0.0, 0.0]
+
+        validity, offsets, values = columns[3]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x07])
+        assert list(memoryview(offsets).tolist()) == [0, 10, 20, 30]
+        assert memoryview(values).tobytes() == b'2015-11-15' * 3
+
+    def test_unpack_columns_fixed_width(self, encoder):
+        """
+        Ensure that schemas made only of fixed width columns, which are
+        decoded using constant column offsets, give the same results.
+        """
+        import struct
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_CHAR, 2, 0, 0),
+            ('col3', TD_FLOAT, 8, 0, 0),
+        ]
+        rows = [
+            b'\x00*\x00\x00\x00ab\x9a\x99\x99\x99\x99\x99\t@',
+            b'\x60\x07\x00\x00\x00  \x00\x00\x00\x00\x00\x00\x00\x00',
+        ]
+        block = b''.join(struct.pack('<H', len(row)) + row for row in rows)
+        columns = encoder.readcolumns(block)
+
+        validity, offsets, values = columns[0]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x03])
+        assert list(memoryview(values).tolist()) == [42, 7]
+
+        validity, offsets, values = columns[1]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x01])
+        assert list(memoryview(offsets).tolist()) == [0, 2, 2]
+        assert memoryview(values).tobytes() == b'ab'
+
+        validity, offsets, values = columns[2]
+        assert bytearray(memoryview(validity).tobytes()) == bytearray([0x01])
+        assert list(memoryview(values).tolist()) == [3.2, 0.0]
+
+    def test_unpack_arrow(self, encoder):
+        """
+        Ensure that a block of rows is exported through the Arrow C Data
+        Interface with the expected formats, buffers and null counts.
+        """
+        import ctypes
+        import struct
+
+        class ArrowSchema(ctypes.Structure):
+            pass
+        ArrowSchema._fields_ = [
+            ('format', ctypes.c_char_p),
+            ('name', ctypes.c_char_p),
+            ('metadata', ctypes.c_char_p),
+            ('flags', ctypes.c_int64),
+            ('n_children', ctypes.c_int64),
+            ('children', ctypes.POINTER(ctypes.POINTER(ArrowSchema))),
+            ('dictionary', ctypes.c_void_p),
+            ('release', ctypes.c_void_p),
+            ('private_data', ctypes.c_void_p),
+        ]
+
+        class ArrowArray(ctypes.Structure):
+            pass
+        ArrowArray._fields_ = [
+            ('length', ctypes.c_int64),
+            ('null_count', ctypes.c_int64),
+            ('offset', ctypes.c_int64),
+            ('n_buffers', ctypes.c_int64),
+            ('n_children', ctypes.c_int64),
+            ('buffers', ctypes.POINTER(ctypes.c_void_p)),
+            ('children', ctypes.POINTER(ctypes.POINTER(ArrowArray))),
+            ('dictionary', ctypes.c_void_p),
+            ('release', ctypes.c_void_p),
+            ('private_data', ctypes.c_void_p),
+        ]
+
+        get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+        get_pointer.restype = ctypes.c_void_p
+        get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+
+        encoder.columns = [
+            ('col1', TD_INTEGER, 4, 0, 0),
+            ('col2', TD_VARCHAR, 50, 0, 0),
+            ('col3', TD_DECIMAL, 4, 8, 2),
+            ('col4', TD_DATE, 4, 0, 0),
+        ]
+        rows = [
+            b'\x00*\x00\x00\x00\x03\x00abc\xd2\x04\x00\x00\x8b\x90\x11\x00',
+            b'\xc0\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x8b\x90\x11\x00',
+            b'\x00\x07\x00\x00\x00\x02\x00de.\xfb\xff\xff\x8b\x90\x11\x00',
+        ]
+        block = b''.join(struct.pack('<H', len(row)) + row for row in rows)
+        batch = encoder.readarrow(block)
+        schema = ctypes.cast(get_pointer(batch.schema_capsule, b"arrow_schema"),
+            ctypes.POINTER(ArrowSchema)).contents
+        array = ctypes.cast(get_pointer(batch.array_capsule, b"arrow_array"),
+            ctypes.POINTER(ArrowArray)).contents
+        assert schema.format == b'+s'
+        assert schema.n_children == 4
+        assert [schema.children[i].contents.format for i in range(4)] == [b'i', b'u', b'd:8,2', b'tdD']
+        assert [schema.children[i].contents.name for i in range(4)] == [b'col1', b'col2', b'col3', b'col4']
+        assert array.length == 3
+        assert array.n_children == 4
+        assert [array.children[i].contents.null_count for i in range(4)] == [1, 1, 0, 0]
+
+        def buffer_at(i, j, n):
+            return ctypes.string_at(array.children[i].contents.buffers[j], n)
+        assert buffer_at(0, 0, 1) == b'\x05'
+        assert struct.unpack('<3i', buffer_at(0, 1, 12)) == (42, 0, 7)
+        assert struct.unpack('<4i', buffer_at(1, 1, 16)) == (0, 3, 3, 5)
+        assert buffer_at(1, 2, 5) == b'abcde'
+        assert struct.unpack('<qq', buffer_at(2, 1, 16)) == (1234, 0)
+        assert struct.unpack('<qq', buffer_at(2, 1, 48)[32:]) == (-1234, -1)
+        assert struct.unpack('<3i', buffer_at(3, 1, 12)) == (16754, 16754, 16754)
+
+    def test_raw_block(self):
+        """
+        Ensure that a raw block is copied from the buffer it was received in
+        only when it is still referenced as it is detached or when a view
+        of it is taken, and that the buffers of copied blocks are reused.
+        """
+        import ctypes
+        import gc
+
+        class RawBlock(ctypes.Structure):
+            _fields_ = [
+                ('ob_refcnt', ctypes.c_ssize_t),
+                ('ob_type', ctypes.c_void_p),
+                ('data', ctypes.c_void_p),
+                ('length', ctypes.c_ssize_t),
+                ('size', ctypes.c_ssize_t),
+                ('owned', ctypes.c_int),
+            ]
+
+        lib = ctypes.PyDLL(giraffez._teradata.__file__)
+        ctypes.pythonapi.PyType_Ready.argtypes = [ctypes.c_void_p]
+        assert ctypes.pythonapi.PyType_Ready(ctypes.addressof(ctypes.c_char.in_dll(lib, "RawBlockType"))) == 0
+        lib.raw_block_new.argtypes = [ctypes.c_void_p, ctypes.c_ssize_t]
+        lib.raw_block_new.restype = ctypes.py_object
+        lib.raw_block_detach.argtypes = [ctypes.c_void_p]
+        lib.raw_block_detach.restype = ctypes.c_int
+
+        # Blocks are passed to raw_block_detach by address so that the
+        # call adds no reference to them
+        source = ctypes.create_string_buffer(b"abcd", 4)
+        block = lib.raw_block_new(ctypes.addressof(source), 4)
+        assert lib.raw_block_detach(id(block)) == 0
+        assert not RawBlock.from_address(id(block)).owned
+        assert RawBlock.from_address(id(block)).data == ctypes.addressof(source)
+
+        kept = [block]
+        assert lib.raw_block_detach(id(block)) == 0
+        assert RawBlock.from_address(id(block)).owned
+        source.raw = b"efgh"
+        assert block.tobytes() == b"abcd"
+        data = RawBlock.from_address(id(block)).data
+        del block, kept
+        gc.collect()
+
+        block = lib.raw_block_new(ctypes.addressof(source), 4)
+        view = memoryview(block)
+        assert RawBlock.from_address(id(block)).owned
+        assert RawBlock.from_address(id(block)).data == data
+        source.raw = b"ijkl"
+        assert view.tobytes() == b"efgh"
+        assert lib.raw_block_detach(id(block)) == 0
+        assert bytes(block) == b"efgh"
+        view.release()
+
 
 
 class TestOther(object):
@@ -7,10 +7,29 @@ import pytest
 from giraffez.__main__ import main
 from giraffez.core import MainCommand
 from giraffez.errors import *
+from giraffez.constants import *
 from giraffez.encrypt import *
+from giraffez.types import Columns
 from giraffez._teradata import TeradataError
 
 
+def mock_export_write_to(mocker, chunks):
+    """Mocks an export whose write_to writes one chunk to the file
+    descriptor per call."""
+    export_mock = mocker.patch('giraffez.export.Export')
+    export_mock().columns.return_value = Columns([
+        ("col1", VARCHAR_NN, 50, 0, 0),
+        ("col2", VARCHAR_N, 50, 0, 0),
+    ])
+    def write_to(fd):
+        if not chunks:
+            return None
+        os.write(fd, chunks.pop(0))
+        return 1
+    export_mock().write_to.side_effect = write_to
+    return export_mock
+
+
 @pytest.mark.usefixtures('tmpfiles')
 class TestCommandLine(object):
     def test_print_help(self, mocker):
@@ -38,3 +57,26 @@ class TestCommandLine(object):
         mock_prompt.side_effect = ConfigNotFound("Did it!")
         with pytest.raises(ConfigNotFound):
             MainCommand().run(test_args=["cmd", "select * from dbc.dbcinfo", "--conf", tmpfiles.noconf])
+
+    @pytest.mark.usefixtures('config')
+    def test_export_write_to(self, mocker, tmpfiles):
+        mock_export_write_to(mocker, [b"value1|value2\n", b"value3|NULL\n"])
+
+        MainCommand().run(test_args=["export", "select * from db1.info", tmpfiles.output_file,
+            "--conf", tmpfiles.conf, "--key", tmpfiles.key])
+
+        # The header is buffered by the writer, so it must be flushed before
+        # the rows are written to the file descriptor
+        with open(tmpfiles.output_file) as f:
+            assert f.read() == "col1|col2\nvalue1|value2\nvalue3|NULL\n"
+
+    @pytest.mark.usefixtures('config')
+    def test_export_write_json_to(self, mocker, tmpfiles):
+        export_mock = mock_export_write_to(mocker, [b'{"col1": "value1", "col2": "value2"}\n'])
+
+        MainCommand().run(test_args=["export", "select * from db1.info", tmpfiles.output_file,
+            "--json", "--conf", tmpfiles.conf, "--key", tmpfiles.key])
+
+        with open(tmpfiles.output_file) as f:
+            assert f.read() == '{"col1": "value1", "col2": "value2"}\n'
+        export_mock().set_encoding.assert_any_call(ROW_ENCODING_JSON)
@@ -1,5 +1,8 @@
 # -*- coding: utf-8 -*-
 
+import struct
+import weakref
+
 import pytest
 
 import giraffez
@@ -7,6 +10,37 @@ from giraffez.constants import *
 from giraffez.errors import *
 from giraffez.types import Columns
 
+row = struct.pack("<HH", 8, 6) + b"value1"
+
+class Block(bytearray):
+    pass
+
+def block_export(mocker, blocks):
+    """Mocks an export returning blocks, recording whether each block had
+    been released by the time the next one was requested."""
+    mocker.patch('giraffez.export.TeradataBulkExport._connect')
+    # The export copies a block that is still referenced when the next
+    # one is received, so nothing else may keep it
+    previous = []
+    released = []
+    def get_block():
+        if previous:
+            released.append(previous.pop()() is None)
+        if not blocks:
+            return None
+        block = Block(blocks.pop(0))
+        previous.append(weakref.ref(block))
+        return block
+
+    export = giraffez.BulkExport()
+    export.export = mocker.MagicMock()
+    export.export.columns.return_value = Columns([
+        ("col1", VARCHAR_NN, 50, 0, 0),
+    ])
+    export.export.get_block.side_effect = get_block
+    export.query = "select * from db1.info"
+    return export, released
+
 @pytest.mark.usefixtures('config', 'context')
 class TestBulkExport(object):
     def test_export_results(self, mocker):
@@ -76,3 +110,69 @@ class TestBulkExport(object):
         assert '’' not in export.query
         assert '“' not in export.query
         assert '”' not in export.query
+
+    def test_export_filtered_buffers(self, mocker):
+        connect_mock = mocker.patch('giraffez.export.TeradataBulkExport._connect')
+        columns = Columns([
+            ("col1", VARCHAR_NN, 50, 0, 0),
+            ("col2", VARCHAR_N, 50, 0, 0),
+        ])
+        rows = [["value1", "value2"], ["value3", "value4"]]
+
+        export = giraffez.BulkExport()
+        export.export = mocker.MagicMock()
+        export.export.columns.return_value = columns
+        # Every row of the first buffer was excluded by the filter
+        export.export.get_buffer.side_effect = [[], rows, None]
+
+        export.query = "select * from db1.info"
+        results = list(export.to_list())
+        export._close()
+
+        assert results == rows
+        assert export.export.get_buffer.call_count == 3
+
+    def test_export_decode_workers(self, mocker):
+        connect_mock = mocker.patch('giraffez.export.TeradataBulkExport._connect')
+        columns = Columns([
+            ("col1", VARCHAR_NN, 50, 0, 0),
+            ("col2", VARCHAR_N, 50, 0, 0),
+        ])
+        rows = [["value1", "value2"], ["value3", "value4"]]
+
+        export = giraffez.BulkExport(decode_workers=4)
+        export.export = mocker.MagicMock()
+        export.export.columns.return_value = columns
+        export.export.get_buffer.side_effect = [rows, None]
+
+        export.query = "select * from db1.info"
+        results = list(export.to_list())
+        export._close()
+
+        assert results == rows
+        export.export.set_workers.assert_called_with(4)
+
+    def test_export_archive_releases_blocks(self, mocker, tmpdir):
+        export, released = block_export(mocker, [row * 2, row * 3])
+
+        path = tmpdir.join("archive.gd").strpath
+        with giraffez.Writer(path, 'wb') as out:
+            counts = list(export.to_archive(out))
+        export._close()
+
+        assert counts == [2, 3]
+        assert released == [True, True]
+        with open(path, 'rb') as f:
+            assert f.read().endswith(row * 5)
+
+    def test_export_blocks_released(self, mocker):
+        export, released = block_export(mocker, [row * 2, row * 3])
+
+        results = []
+        for block in export.to_blocks():
+            results.append(bytes(block))
+            del block
+        export._close()
+
+        assert results == [row * 2, row * 3]
+        assert released == [True, True]